@@ -4,118 +4,70 @@
 #include "Shooter.h"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
-#include <SDL3_image/SDL_image.h>
-#include "gameobject.h"
-#include <vector>
-#include <glm/glm.hpp>
-#include <array>
+#include "game.h"
+#include "input.h"
+#include "replay.h"
+#include "profiler.h"
+#include <algorithm>
 #include <format>
+#include <filesystem>
 
 using namespace std;
 
-struct SDLState {
-	SDL_Window* window;
-	SDL_Renderer* renderer;
-	int width, height, logW, logH;
-	const bool* keys;
-
-	SDLState() : keys(SDL_GetKeyboardState(nullptr)) {
-
-	}
-};
-
-struct Resources {
-	const int ANIM_PLAYER_IDLE = 0;
-	const int ANIM_PLAYER_RUN = 1;
-	const int ANIM_PLAYER_SLIDING = 2;
-	std::vector<Animation> playerAnims;
-	const int ANIM_BULLET_MOVING = 0;
-	const int ANIM_BULLET_HIT = 1;
-	std::vector<Animation> bulletAnims;
-
-	std::vector<SDL_Texture*> textures;
-	SDL_Texture* texIdle, * textRun, * texSlide, * texBrick, * texGrass, * texGround, * texPanel, * texBg1, * texBg2, * texBg3, * texBg4,
-		* texBullet, * texBulletHit;
-
-	SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& filepath) {
-
-		SDL_Texture* tex = IMG_LoadTexture(renderer, filepath.c_str());
-		SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
-		textures.push_back(tex);
-		return tex;
-	}
-
-	void load(SDLState& state) {
-		playerAnims.resize(5);
-		playerAnims[ANIM_PLAYER_IDLE] = Animation(8, 1.6f);
-		playerAnims[ANIM_PLAYER_RUN] = Animation(4, 0.5f);
-		playerAnims[ANIM_PLAYER_SLIDING] = Animation(1, 1.0f);
-		bulletAnims.resize(2);
-		bulletAnims[ANIM_BULLET_MOVING] = Animation(4, 0.05f);
-		bulletAnims[ANIM_BULLET_HIT] = Animation(4, 0.15f);
-
-		texIdle = loadTexture(state.renderer, "Shooter/data/idle.png");
-		textRun = loadTexture(state.renderer, "Shooter/data/run.png");
-		texSlide = loadTexture(state.renderer, "Shooter/data/slide.png");
-		texBrick = loadTexture(state.renderer, "Shooter/data/tiles/brick.png");
-		texGrass = loadTexture(state.renderer, "Shooter/data/tiles/grass.png");
-		texGround = loadTexture(state.renderer, "Shooter/data/tiles/ground.png");
-		texPanel = loadTexture(state.renderer, "Shooter/data/tiles/panel.png");
-		texBg1 = loadTexture(state.renderer, "Shooter/data/bg/bg_layer1.png");
-		texBg2 = loadTexture(state.renderer, "Shooter/data/bg/bg_layer2.png");
-		texBg3 = loadTexture(state.renderer, "Shooter/data/bg/bg_layer3.png");
-		texBg4 = loadTexture(state.renderer, "Shooter/data/bg/bg_layer4.png");
-		texBullet = loadTexture(state.renderer, "Shooter/data/bullet.png");
-		texBulletHit = loadTexture(state.renderer, "Shooter/data/bullet_hit.png");
+// Hands every tick its input, from the keyboard, an input script or a replay, and records it to a replay file
+// when asked to. A replay is checked tick by tick against the state hashes it was recorded with
+struct TickInputs {
+	enum class Source {
+		keyboard, script, replay
+	};
+	Source source = Source::keyboard;
+	ScriptedInput script;
+	replay::Replay replay;
+	ReplayWriter recorder;
+	uint8_t presses = 0;	// keyboard presses since the last tick
+	int tick = 0;
+	int desyncTick = -1;	// the first tick that didn't end the way it did when it was recorded
+
+	bool isDone() const { return source == Source::replay && tick >= static_cast<int>(replay.ticks()); }
+
+	TickInput next(const SDLState& state) {
+		switch (source) {
+			case Source::script: {
+				return script.sample(tick);
+			}
+			case Source::replay: {
+				return replay.inputs[tick];
+			}
+			default: {
+				const TickInput input = TickInput::sample(state.keys, presses);
+				presses = 0;
+				return input;
+			}
+		}
 	}
 
-	void unload() {
-		for (SDL_Texture* tex : textures) {
-			SDL_DestroyTexture(tex);
+	// once the tick next() handed the input of has been simulated
+	void endTick(GameState& gameState, TickInput input) {
+		if (recorder.isRecording() || source == Source::replay) {
+			const uint32_t hash = hashState(gameState);
+			if (recorder.isRecording()) {
+				recorder.add(input, hash);
+			}
+			if (source == Source::replay && desyncTick == -1 && hash != replay.hashes[tick]) {
+				desyncTick = tick;
+			}
 		}
+		tick++;
 	}
 };
 
-const size_t LAYER_IDX_LEVEL = 0;
-const size_t LAYER_IDX_CHARACTERS = 1;
-const int MAP_ROWS = 5;
-const int MAP_COLS = 50;
-const int TILE_SIZE = 32;
-
-struct GameState {
-	std::array<std::vector<GameObject>, 2> layers;
-	std::vector<GameObject> backgroundTiles;
-	std::vector<GameObject> foregroundTiles;
-	std::vector<GameObject> bullets;
-
-	int playerIndex;
-	SDL_FRect mapViewport;
-	float bg2Scroll, bg3Scroll, bg4Scroll;
-
-	GameState(const SDLState &state) {
-		playerIndex = -1;
-		mapViewport = SDL_FRect{
-			.x = 0,
-			.y = 0,
-			.w = static_cast<float>(state.logW),
-			.h = static_cast<float>(state.logH)
-		};
-		bg2Scroll = bg3Scroll = bg4Scroll = 0;
-	};
-
-	GameObject &player() { return layers[LAYER_IDX_CHARACTERS][playerIndex]; }
-};
-
 bool initialize(SDLState &state);
 void cleanup(SDLState &win);
-void drawObject(const SDLState& state, GameState& gameState, GameObject& obj, float width, float height, float deltaTime);
-void update(const SDLState& state, GameState& gameStaet, Resources& resources, GameObject& obj, float deltaTime);
-void createTiles(const SDLState& state, GameState& gameState, const Resources& resources);
-void checkCollissions(const SDLState& state, GameState& gameState, Resources& resources,
-	GameObject& a, GameObject& b, float deltaTime);
-void handleKeyInput(const SDLState& state, GameState& gs, GameObject& obj, SDL_Scancode key, bool keyDown);
-void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos, float scrollFactor,
-	float deltaTime);
+bool openInputs(TickInputs& inputs, bool scripted, int& ticks, const std::string& scriptPath, const std::string& replayPath,
+	const std::string& recordPath, std::string& levelPath);
+bool finishInputs(TickInputs& inputs);
+int runHeadless(SDLState& state, JobSystem& jobs, int ticks, TickInputs& inputs, const std::string& levelPath);
+void printTimedemo(std::vector<uint64_t> frameTimes, uint64_t wallNs);
 
 int main(int argc, char *argv[])
 {
@@ -125,130 +77,284 @@ int main(int argc, char *argv[])
 	state.logW = 640;
 	state.logH = 320;
 
+	bool headless = false;
+	bool timedemo = false;
+	int ticks = 3600;
+	int threads = static_cast<int>(std::thread::hardware_concurrency());
+	std::string scriptPath;
+	std::string replayPath;
+	std::string recordPath;
+	std::string levelPath;
+	std::string tracePath = "trace.json";
+	[[maybe_unused]] int traceFrames = 300;
+	bool traceAtStart = false;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--timedemo") {
+			timedemo = true;
+		}
+		else if (arg == "--ticks" && i + 1 < argc) {
+			ticks = std::atoi(argv[++i]);
+		}
+		else if (arg == "--script" && i + 1 < argc) {
+			scriptPath = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc) {
+			replayPath = argv[++i];
+		}
+		else if (arg == "--record" && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			threads = std::atoi(argv[++i]);
+		}
+		else if (arg == "--level" && i + 1 < argc) {
+			levelPath = argv[++i];
+		}
+		else if (arg == "--trace" && i + 1 < argc) {
+			tracePath = argv[++i];
+			traceAtStart = true;
+		}
+		else if (arg == "--trace-frames" && i + 1 < argc) {
+			traceFrames = std::atoi(argv[++i]);
+		}
+	}
+
+	// the levels are copied next to the executable, run from the source tree without them the ones in it are used
+	if (levelPath.empty()) {
+		const char* basePath = SDL_GetBasePath();
+		levelPath = std::string(basePath ? basePath : "") + "levels/level1.lvl";
+		if (!std::filesystem::exists(levelPath)) {
+			levelPath = "Shooter/data/levels/level1.lvl";
+		}
+	}
+
+	PROFILE_THREAD("main");
+
+	// captures traceFrames frames, the first one to tracePath and the ones F4 starts after it numbered
+	[[maybe_unused]] int traceCount = 0;
+	const auto startTrace = [&] {
+#if SHOOTER_PROFILING
+		std::filesystem::path path = tracePath;
+		if (traceCount > 0) {
+			path.replace_filename(std::format("{}_{}{}", path.stem().string(), traceCount + 1, path.extension().string()));
+		}
+		if (profiler::Profiler::get().startTrace(path.string(), traceFrames)) {
+			traceCount++;
+			std::cout << std::format("tracing {} frames to {}", traceFrames, path.string()) << std::endl;
+		}
+#else
+		std::cerr << "Built without SHOOTER_PROFILING, there is nothing to trace" << std::endl;
+#endif
+	};
+	if (traceAtStart) {
+		startTrace();
+	}
+
+	JobSystem jobs(threads);
+
+	// with no keyboard to play, the script is played. A timedemo plays it back drawing a frame for every tick
+	// as fast as it can
+	TickInputs inputs;
+	if (!openInputs(inputs, headless || timedemo, ticks, scriptPath, replayPath, recordPath, levelPath)) {
+		return 1;
+	}
+
+	if (headless) {
+		return runHeadless(state, jobs, ticks, inputs, levelPath);
+	}
+
 	if (!initialize(state)) {
 		return 1;
 	}
+	if (timedemo) {
+		SDL_SetRenderVSync(state.renderer, 0);
+	}
 	
 	//load game assets
 	Resources resources;
-	resources.load(state);
+	resources.load(state, jobs);
 
 	//setup game data
-	GameState gameState(state);
-	createTiles(state, gameState, resources);
+	GameState gameState(state, jobs);
+	if (!loadLevel(state, gameState, resources, levelPath)) {
+		resources.unload();
+		cleanup(state);
+		return 1;
+	}
+	gameState.backgroundChunks.create(state.renderer, gameState.background, CHUNK_COLS);
+	gameState.levelChunks.create(state.renderer, gameState.level, CHUNK_COLS);
+	gameState.foregroundChunks.create(state.renderer, gameState.foreground, CHUNK_COLS);
 
-	uint64_t prevTime = SDL_GetTicks();
+	uint64_t prevTime = SDL_GetTicksNS();
+	const uint64_t demoStart = prevTime;
+	uint64_t accumulator = 0;
+	std::vector<uint64_t> demoFrameTimes;
+	demoFrameTimes.reserve(timedemo ? ticks : 0);
 
 	//main loop
 	bool running = true;
+	bool streamFailed = false;
 	while (running) {
-		uint64_t nowTime = SDL_GetTicks();
-		float deltaTime = (nowTime - prevTime) / 1000.0f;
-		SDL_Event event{ 0 };
-		while (SDL_PollEvent(&event)) {
-			switch (event.type) {
-				case SDL_EVENT_QUIT:
-					running = false;
-					break;
-				case SDL_EVENT_WINDOW_RESIZED:
-					state.width = event.window.data1;
-					state.height = event.window.data2;
-					break;
-				case SDL_EVENT_KEY_DOWN: 
-					handleKeyInput(state, gameState, gameState.player(), event.key.scancode, true);
-					break;
-				
-				case SDL_EVENT_KEY_UP: 
-					handleKeyInput(state, gameState, gameState.player(), event.key.scancode, false);
-					break;
+		uint64_t nowTime = SDL_GetTicksNS();
+		// a timedemo steps exactly one tick a frame, however long the frame took
+		uint64_t frameTime = timedemo ? SIM_STEP_NS : nowTime - prevTime;
+		float deltaTime = frameTime / static_cast<float>(SDL_NS_PER_SECOND);
+		{
+			PROFILE_SCOPE(events);
+			SDL_Event event{ 0 };
+			while (SDL_PollEvent(&event)) {
+				switch (event.type) {
+					case SDL_EVENT_QUIT:
+						running = false;
+						break;
+					case SDL_EVENT_WINDOW_RESIZED:
+						state.width = event.window.data1;
+						state.height = event.window.data2;
+						break;
+					case SDL_EVENT_KEY_DOWN: 
+						if (event.key.scancode == SDL_SCANCODE_F3 && !event.key.repeat) {
+							gameState.showOverlay = !gameState.showOverlay;
+						}
+						if (event.key.scancode == SDL_SCANCODE_F4 && !event.key.repeat) {
+							startTrace();
+						}
+						// kept for the next tick, the simulation only sees input a tick at a time
+						inputs.presses |= TickInput::pressBit(event.key.scancode);
+						break;
 				
+				}
 			}
 		}
 
-		//update all objects
-		for (auto& layer : gameState.layers) {
-
-			for (GameObject& obj : layer) {
-
-				update(state, gameState, resources, obj, deltaTime);
-				//update the animation
-				if (obj.currentAnimation != -1) {
+		// the level around the viewport has to be in before anything touches it
+		{
+			PROFILE_SCOPE(stream);
+			if (!streamWorld(gameState)) {
+				streamFailed = true;
+				break;
+			}
+		}
 
-					obj.animations[obj.currentAnimation].step(deltaTime);
-				}
+		// step the simulation in fixed ticks, dropping time we can't catch up on after a hitch
+		gameState.pairTests = 0;
+		gameState.bodyCounts = {};
+		accumulator += frameTime;
+		if (accumulator > MAX_SIM_STEPS * SIM_STEP_NS) {
+			accumulator = MAX_SIM_STEPS * SIM_STEP_NS;
+		}
+		{
+			PROFILE_SCOPE(simulate);
+			while (accumulator >= SIM_STEP_NS && !inputs.isDone()) {
+				// every tick sees the viewport where the last tick left the player, however many run a frame
+				followPlayer(gameState, gameState.world.get<Position>(gameState.player).value.x);
+				const TickInput input = inputs.next(state);
+				applyInput(state, gameState, input);
+				simulate(state, gameState, resources, SIM_DELTA_TIME);
+				inputs.endTick(gameState, input);
+				accumulator -= SIM_STEP_NS;
 			}
 		}
 
-		//update bullets
-		for (GameObject& bullet : gameState.bullets) {
+		// how far we are between the previous and the current tick
+		const float alpha = accumulator / static_cast<float>(SIM_STEP_NS);
 
-			update(state, gameState, resources, bullet, deltaTime);
-			//update the animation
-			if (bullet.currentAnimation != -1) {
+		// calculate viewport position for drawing
+		World& world = gameState.world;
+		const Position& playerPos = world.get<Position>(gameState.player);
+		followPlayer(gameState, glm::mix(playerPos.prev.x, playerPos.value.x, alpha));
 
-				bullet.animations[bullet.currentAnimation].step(deltaTime);
+		// bake a chunk that is about to scroll in now rather than on the frame it does
+		{
+			PROFILE_SCOPE(tiles);
+			for (TileChunks* chunks : { &gameState.backgroundChunks, &gameState.levelChunks, &gameState.foregroundChunks }) {
+				chunks->prebake(state.renderer, gameState.sprites, resources.tileSprites, gameState.mapViewport, CHUNK_COLS * TILE_SIZE, 1);
 			}
 		}
 
-		// calculate viewport position
-		gameState.mapViewport.x = (gameState.player().position.x + TILE_SIZE / 2) - gameState.mapViewport.w / 2;
-
 		//drawing commands
-		SDL_SetRenderDrawColor(state.renderer, 20, 10, 30, 255);
-		SDL_RenderClear(state.renderer);
-
-		SDL_RenderTexture(state.renderer, resources.texBg1, nullptr, nullptr);
-		drawParalaxBackground(state.renderer, resources.texBg4, gameState.player().velocity.x, gameState.bg4Scroll, 0.075f, deltaTime);
-		drawParalaxBackground(state.renderer, resources.texBg3, gameState.player().velocity.x, gameState.bg3Scroll, 0.150f, deltaTime);
-		drawParalaxBackground(state.renderer, resources.texBg2, gameState.player().velocity.x, gameState.bg2Scroll, 0.3f, deltaTime);
+		{
+			PROFILE_SCOPE(background);
+			SDL_SetRenderDrawColor(state.renderer, 20, 10, 30, 255);
+			SDL_RenderClear(state.renderer);
+
+			const float playerVelX = world.get<Velocity>(gameState.player).value.x;
+			SDL_RenderTexture(state.renderer, resources.texBg1, nullptr, nullptr);
+			drawParalaxBackground(state.renderer, resources.texBg4, playerVelX, gameState.bg4Scroll, 0.075f, deltaTime);
+			drawParalaxBackground(state.renderer, resources.texBg3, playerVelX, gameState.bg3Scroll, 0.150f, deltaTime);
+			drawParalaxBackground(state.renderer, resources.texBg2, playerVelX, gameState.bg2Scroll, 0.3f, deltaTime);
+		}
 
-		// draw background tiles
-		for (GameObject& obj : gameState.backgroundTiles) {
-			SDL_FRect dst{
-				.x = obj.position.x - gameState.mapViewport.x,
-				.y = obj.position.y,
-				.w = static_cast<float>(obj.texture->w),
-				.h = static_cast<float>(obj.texture->h)
-			};
-			SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+		{
+			PROFILE_SCOPE(tiles);
+			drawTiles(state, gameState, resources, gameState.backgroundChunks);
+			drawTiles(state, gameState, resources, gameState.levelChunks);
 		}
 
 		//draw all objects
-		for (auto& layer : gameState.layers) {
-
-			for (GameObject& obj : layer) {
-				drawObject(state, gameState, obj, TILE_SIZE, TILE_SIZE, deltaTime);
+		{
+			PROFILE_SCOPE(objects);
+			for (auto [e, pos, body, sprite] : world.view<Position, Body, Sprite>()) {
+				if (drawObject(state, gameState, resources, pos, body, sprite, alpha)) {
+					gameState.drawnCount++;
+				}
+				else {
+					gameState.culledCount++;
+				}
 			}
+			gameState.sprites.flush(state.renderer);
 		}
 
-		//draw bullets
-		for (GameObject &bullet : gameState.bullets) {
-			drawObject(state, gameState, bullet, bullet.collider.w, bullet.collider.h, deltaTime);
+		{
+			PROFILE_SCOPE(tiles);
+			drawTiles(state, gameState, resources, gameState.foregroundChunks);
 		}
 
-		// draw foreground tiles
-		for (GameObject& obj : gameState.foregroundTiles) {
-			SDL_FRect dst{
-				.x = obj.position.x - gameState.mapViewport.x,
-				.y = obj.position.y,
-				.w = static_cast<float>(obj.texture->w),
-				.h = static_cast<float>(obj.texture->h)
-			};
-			SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+		if (gameState.showOverlay) {
+			PROFILE_SCOPE(overlay);
+			drawOverlay(state, gameState);
 		}
-
-		SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
-		SDL_RenderDebugText(state.renderer, 5, 5, 
-			std::format("State: {}", static_cast<int>(gameState.player().data.player.state)).c_str());
+		gameState.sprites.resetStats();
+		gameState.drawnCount = gameState.culledCount = 0;
 
 		// swap buffers and present
-		SDL_RenderPresent(state.renderer);
+		{
+			PROFILE_SCOPE(present);
+			SDL_RenderPresent(state.renderer);
+		}
+		const uint64_t frameEnd = SDL_GetTicksNS();
+		PROFILE_END_FRAME(frameEnd - nowTime);
 		prevTime = nowTime;
+
+		if (timedemo) {
+			demoFrameTimes.push_back(frameEnd - nowTime);
+			if (inputs.tick == ticks) {
+				running = false;
+			}
+		}
+		if (inputs.isDone()) {
+			running = false;
+		}
 	}
 
+	// a run cut short by the level failing to stream has nothing worth reporting
+	bool success = !streamFailed;
+	if (success) {
+		if (timedemo && !demoFrameTimes.empty()) {
+			printTimedemo(demoFrameTimes, SDL_GetTicksNS() - demoStart);
+		}
+		success = finishInputs(inputs);
+	}
+
+	gameState.backgroundChunks.release();
+	gameState.levelChunks.release();
+	gameState.foregroundChunks.release();
 	resources.unload();
 	SDL_Quit();
-	return 0;
+	return success ? 0 : 1;
 }
 
 bool initialize(SDLState& state) {
@@ -288,374 +394,166 @@ void cleanup(SDLState &state ) {
 	SDL_Quit();
 }
 
-void drawObject(const SDLState& state, GameState& gameState, GameObject& obj, float width, float height, float deltaTime) {
-
-	float sourceX = obj.currentAnimation != -1 ?
-		obj.animations[obj.currentAnimation].currentFrame() * width : 0.0f;
-
-	SDL_FRect src{
-		.x = sourceX,
-		.y = 0,
-		.w = width,
-		.h = height
-	};
-	SDL_FRect dst{
-		.x = obj.position.x - gameState.mapViewport.x ,
-		.y = obj.position.y,
-		.w = width,
-		.h = height
-	};
-
-	SDL_FlipMode flipMode = obj.direction == -1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-
-	SDL_RenderTextureRotated(state.renderer,obj.texture, &src, &dst, 0, nullptr, flipMode);
-
-}
-
-void update(const SDLState& state, GameState& gameStaet, Resources& resources, GameObject& obj, float deltaTime) {
-	
-	if (obj.dynamic) {
-		//apply some gravity
-		obj.velocity += glm::vec2(0, 500) * deltaTime;
-	}
-
-	if (obj.type == ObjectType::player) {
-		float currentDirection = 0;
+// scripted is whether to play the script rather than the keyboard. A replay plays instead of either, on the
+// level it was recorded on and for as many ticks as it holds
+bool openInputs(TickInputs& inputs, bool scripted, int& ticks, const std::string& scriptPath, const std::string& replayPath,
+	const std::string& recordPath, std::string& levelPath) {
 
-		if (state.keys[SDL_SCANCODE_A]) {
-			currentDirection += -1;
+	if (!replayPath.empty()) {
+		std::string error;
+		if (!replay::load(replayPath, inputs.replay, error)) {
+			std::cerr << "Failed to load replay " << replayPath << ": " << error << std::endl;
+			return false;
 		}
-
-		if (state.keys[SDL_SCANCODE_D]) {
-			currentDirection += 1;
+		inputs.source = TickInputs::Source::replay;
+		ticks = static_cast<int>(inputs.replay.ticks());
+		levelPath = inputs.replay.levelPath;
+	}
+	else if (scripted) {
+		inputs.source = TickInputs::Source::script;
+		if (scriptPath.empty()) {
+			inputs.script.loadDefault(ticks);
 		}
-
-		if (currentDirection) {
-			obj.direction = currentDirection;
+		else if (!inputs.script.load(scriptPath)) {
+			std::cerr << "Failed to load input script " << scriptPath << std::endl;
+			return false;
 		}
+	}
 
-		Timer& weaponTimer = obj.data.player.weaponTimer;
-		weaponTimer.step(deltaTime);
-
-		switch (obj.data.player.state) {
-
-			case PlayerState::idle: {
-				// switching to running state
-				if (currentDirection) {
-					obj.data.player.state = PlayerState::running;
-				}
-				else {
-					if (obj.velocity.x) {
-						const float factor = obj.velocity.x > 0 ? -1.5f : 1.5f;
-						float amount = factor * obj.acceleration.x * deltaTime;
-						if (std::abs(obj.velocity.x) < std::abs(amount)) {
-							obj.velocity.x = 0;
-						}
-						else {
-							obj.velocity.x += amount;
-						}
-					}
-				}
-				if (state.keys[SDL_SCANCODE_J]) {
-
-					if (weaponTimer.isTimeout()) {
-						weaponTimer.reset();
-
-						//spawn some bullets
-						GameObject bullet;
-						bullet.type = ObjectType::bullet;
-						bullet.direction = gameStaet.player().direction;
-						bullet.texture = resources.texBullet;
-						bullet.currentAnimation = resources.ANIM_BULLET_MOVING;
-						bullet.collider = SDL_FRect{
-							.x = 0,
-							.y = 0,
-							.w = static_cast<float>(resources.texBullet->h),
-							.h = static_cast<float>(resources.texBullet->h),
-						};
-						bullet.velocity = glm::vec2(
-							obj.velocity.x + 600.0f * obj.direction,
-							0
-						);
-						bullet.animations = resources.bulletAnims;
-
-						const float left = 4;
-						const float right = 24;
-						const float t = (obj.direction + 1) / 2.0f;
-						const float xOffset = left + right * t;
-
-						bullet.position = glm::vec2(obj.position.x + xOffset, obj.position.y + TILE_SIZE / 2 + 1);
-						gameStaet.bullets.push_back(bullet);
-					}
-
-				}
-				obj.texture = resources.texIdle;
-				obj.currentAnimation = resources.ANIM_PLAYER_IDLE;
-				break;
-			}
-			
-			case PlayerState::running: {
-				if (!currentDirection) {
-					obj.data.player.state = PlayerState::idle;
-
-				}
-
-				// moving in opposite direction of velocity, sliding !
-				if (obj.velocity.x * obj.direction < 0 && obj.grounded) {
-					obj.texture = resources.texSlide;
-					obj.currentAnimation = resources.ANIM_PLAYER_SLIDING;
-				}
-				else {
-					obj.texture = resources.textRun;
-					obj.currentAnimation = resources.ANIM_PLAYER_RUN;
-				}
-				
-				break;
-			}
+	if (!recordPath.empty() && !inputs.recorder.open(recordPath, levelPath)) {
+		std::cerr << "Failed to write replay " << recordPath << std::endl;
+		return false;
+	}
+	return true;
+}
 
-			case PlayerState::jumping: {
-				obj.texture = resources.textRun;
-				obj.currentAnimation = resources.ANIM_PLAYER_RUN;
-			}
-		}
+// false when a replay desynced or the recording couldn't be written, so either fails the run
+bool finishInputs(TickInputs& inputs) {
 
-		//add acceleration to velocity
-		obj.velocity += currentDirection * obj.acceleration * deltaTime;
-		if (std::abs(obj.velocity.x) > obj.maxSpeedX) {
-			obj.velocity.x = currentDirection * obj.maxSpeedX;
+	bool success = true;
+	if (inputs.source == TickInputs::Source::replay) {
+		if (inputs.desyncTick == -1) {
+			std::cout << std::format("replay: {} ticks played, every one matched the recording", inputs.tick) << std::endl;
 		}
-	}
-	//add velocity to position
-	obj.position += obj.velocity * deltaTime;
-
-	//handle collision detection
-
-	bool foundGround = false;
-	for (auto& layer : gameStaet.layers) {
-		for (GameObject& objB : layer) {
-			if (&obj != &objB) {
-				checkCollissions(state, gameStaet, resources, obj, objB, deltaTime);
-
-				//grounded sensor
-				SDL_FRect sensor{
-					.x = obj.position.x + obj.collider.x,
-					.y = obj.position.y + obj.collider.y + obj.collider.h,
-					.w = obj.collider.w,
-					.h = 1
-				};
-
-				SDL_FRect rectB{
-					.x = objB.position.x + objB.collider.x,
-					.y = objB.position.y + objB.collider.y,
-					.w = objB.collider.w,
-					.h = objB.collider.h
-				};
-
-				if (SDL_HasRectIntersectionFloat(&sensor, &rectB)) {
-					foundGround = true;
-				}
-			}
+		else {
+			std::cout << std::format("replay: {} ticks played, desynced from the recording at tick {}", inputs.tick,
+				inputs.desyncTick) << std::endl;
+			success = false;
 		}
 	}
-
-	if (obj.grounded != foundGround) {
-		// switching grounded state
-		obj.grounded = foundGround;
-		if (foundGround && obj.type == ObjectType::player) {
-			obj.data.player.state = PlayerState::running;
+	if (inputs.recorder.isRecording()) {
+		const uint64_t recorded = inputs.recorder.getTicks();
+		if (inputs.recorder.close()) {
+			std::cout << std::format("replay: {} ticks recorded", recorded) << std::endl;
 		}
-	}
-}
-
-void collisionResponse(const SDLState& state, GameState& gameState, Resources &resources,
-	const SDL_FRect &rectA, const SDL_FRect &rectB, const SDL_FRect &rectC, GameObject& objA, GameObject& objB, float deltaTime) {
-
-	if (objA.type == ObjectType::player) {
-
-		switch (objB.type) {
-			case ObjectType::level: {
-				if (rectC.w < rectC.h) {
-					//horizonal collision
-					if (objA.velocity.x > 0) {
-						objA.position.x -= rectC.w;
-					}
-					else if (objA.velocity.x < 0) { //going left
-						objA.position.x += rectC.w;
-					}
-					objA.velocity.x = 0;
-				}
-				else {
-					//vertical collision
-					if (objA.velocity.y > 0) {
-						objA.position.y -= rectC.h;
-					}
-					else if (objA.velocity.y < 0) {
-						objA.position.y += rectC.h;
-					}
-					objA.velocity.y = 0;
-				}
-				break;
-			}
+		else {
+			std::cerr << "Failed to write the replay" << std::endl;
+			success = false;
 		}
 	}
+	return success;
 }
 
-void checkCollissions(const SDLState& state, GameState& gameState, Resources &resources, 
-	GameObject &a, GameObject &b, float deltaTime) {
+int runHeadless(SDLState& state, JobSystem& jobs, int ticks, TickInputs& inputs, const std::string& levelPath) {
 
-	SDL_FRect rectA{
-		.x = a.position.x + a.collider.x,
-		.y = a.position.y + a.collider.y,
-		.w = a.collider.w,
-		.h = a.collider.h
-	};
-
-	SDL_FRect rectB{
-	.x = b.position.x + b.collider.x,
-	.y = b.position.y + b.collider.y,
-	.w = b.collider.w,
-	.h = b.collider.h
-	};
-	SDL_FRect rectC{ 0 };
-
-	if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC)) {
-		collisionResponse(state, gameState, resources, rectA, rectB, rectC, a, b, deltaTime);
+	if (!SDL_Init(0)) {
+		std::cerr << "Failed to initialize SDL" << std::endl;
+		return 1;
 	}
-}
-
-void createTiles(const SDLState& state, GameState& gameState, const Resources& resources) {
-
-	short map[MAP_ROWS][MAP_COLS] = {
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-	};
-
-	short foreground[MAP_ROWS][MAP_COLS] = {
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		5, 0, 0, 5, 5, 5, 5, 5, 5, 0, 0, 5, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	};
-
-	short background[MAP_ROWS][MAP_COLS] = {
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		5, 0, 0, 5, 5, 5, 5, 5, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	};
-
-	const auto loadMap = [&state, &gameState, &resources](short layer[MAP_ROWS][MAP_COLS]) {
-
-		const auto createObject = [&state](int r, int c, SDL_Texture* tex, ObjectType type) {
-			GameObject o;
-			o.type = type;
-			o.position = glm::vec2(c * TILE_SIZE, state.logH - (MAP_ROWS - r) * TILE_SIZE);
-			o.texture = tex;
-			o.collider = { .x = 0, .y = 0 , .w = TILE_SIZE, .h = TILE_SIZE };
-			return o;
-			};
-
-		for (int r = 0; r < MAP_ROWS; r++) {
-			for (int c = 0; c < MAP_COLS; c++) {
-				switch (layer[r][c]) {
-
-				case 1: { // ground
-					GameObject o = createObject(r, c, resources.texGround, ObjectType::level);
-					gameState.layers[LAYER_IDX_LEVEL].push_back(o);
-					break;
-				}
-
-				case 2: { // panel
-					GameObject o = createObject(r, c, resources.texPanel, ObjectType::level);
-					gameState.layers[LAYER_IDX_LEVEL].push_back(o);
-					break;
-				}
 
-				case 4: {
-
-					// create our player
-					GameObject player = createObject(r, c, resources.texIdle, ObjectType::player);
-					player.data.player = PlayerData();
-					player.animations = resources.playerAnims;
-					player.currentAnimation = resources.ANIM_PLAYER_IDLE;
-					player.acceleration = glm::vec2(300, 0);
-					player.maxSpeedX = 100;
-					player.dynamic = true;
-					player.collider = {
-						.x = 11, .y = 6, .w = 10, .h = 26
-					};
-					gameState.layers[LAYER_IDX_CHARACTERS].push_back(player);
-					gameState.playerIndex = gameState.layers[LAYER_IDX_CHARACTERS].size() - 1;
-					break;
-				}
+	Resources resources;
+	resources.load(state, jobs);
 
-				case 5: { //grass
-					GameObject o = createObject(r, c, resources.texGrass, ObjectType::level);
-					gameState.foregroundTiles.push_back(o);
-					break;
-				}
+	GameState gameState(state, jobs);
+	if (!loadLevel(state, gameState, resources, levelPath)) {
+		SDL_Quit();
+		return 1;
+	}
 
-				case 6: {
-					GameObject o = createObject(r, c, resources.texBrick, ObjectType::level);
-					gameState.backgroundTiles.push_back(o);
-					break;
-				}
-				}
+	// run the simulation as fast as we can, nothing is drawn
+	uint64_t totalPairTests = 0;
+	std::array<uint64_t, 3> totalBodies{};
+	const uint64_t startTime = SDL_GetTicksNS();
+	for (int tick = 0; tick < ticks; tick++) {
+		const TickInput input = inputs.next(state);
+		[[maybe_unused]] const uint64_t tickStart = SDL_GetTicksNS();
+		{
+			PROFILE_SCOPE(stream);
+			if (!streamWorld(gameState)) {
+				SDL_Quit();
+				return 1;
 			}
 		}
-	};
-
-	loadMap(map);
-	loadMap(background);
-	loadMap(foreground);
-	assert(gameState.playerIndex != -1);
-}
-
-void handleKeyInput(const SDLState &state, GameState &gs, GameObject &obj, SDL_Scancode key, bool keyDown) {
-	
-	const float JUMP_FORCE = -200.0f;
-
-	if (obj.type == ObjectType::player) {
-
-		switch (obj.data.player.state) {
-
-			case PlayerState::idle: 
-				if (key == SDL_SCANCODE_K && keyDown) {
-					obj.data.player.state = PlayerState::jumping;
-					obj.velocity.y += JUMP_FORCE;
-				}
-				break;
-			
-
-			case PlayerState::running: 
-				if (key == SDL_SCANCODE_K && keyDown) {
-					obj.data.player.state = PlayerState::jumping;
-					obj.velocity.y += JUMP_FORCE;
-				}
-				break;
-			
+		gameState.pairTests = 0;
+		gameState.bodyCounts = {};
+		{
+			PROFILE_SCOPE(simulate);
+			applyInput(state, gameState, input);
+			simulate(state, gameState, resources, SIM_DELTA_TIME);
+		}
+		inputs.endTick(gameState, input);
+		followPlayer(gameState, gameState.world.get<Position>(gameState.player).value.x);
+		totalPairTests += gameState.pairTests;
+		for (size_t i = 0; i < totalBodies.size(); i++) {
+			totalBodies[i] += gameState.bodyCounts[i];
 		}
+		// every tick is a frame to the profiler
+		PROFILE_END_FRAME(SDL_GetTicksNS() - tickStart);
 	}
-}
+	const uint64_t elapsed = SDL_GetTicksNS() - startTime;
+
+	const double seconds = elapsed / static_cast<double>(SDL_NS_PER_SECOND);
+	std::cout << std::format("{} worker threads", jobs.workerCount()) << std::endl;
+	std::cout << std::format("{} ticks in {:.3f} s: {:.0f} ticks/s, {:.2f} us/tick, {:.1f} pair tests/tick, {} bullets",
+		ticks, seconds, ticks / seconds, elapsed / 1000.0 / ticks, totalPairTests / static_cast<double>(ticks),
+		gameState.bulletCount) << std::endl;
+	const glm::vec2& playerPos = gameState.world.get<Position>(gameState.player).value;
+	std::cout << std::format("player at {:.2f}, {:.2f}", playerPos.x, playerPos.y) << std::endl;
+	std::cout << std::format("bodies processed: {} stationary (not ticked), {} kinematic, {} dynamic",
+		totalBodies[0], totalBodies[1], totalBodies[2]) << std::endl;
+	const WorldStream::Stats& stream = gameState.stream.getStats();
+	std::cout << std::format("level: {}x{} tiles, {} columns of {} bytes per layer in memory", gameState.level.getCols(),
+		gameState.level.getRows(), gameState.level.getWindowCols(), gameState.level.memoryUsage()) << std::endl;
+	std::cout << std::format("stream: {}/{} chunks resident, {} loads, {} evictions, {} stalls ({:.2f} ms), latency {:.3f} ms avg {:.3f} ms max, {:.2f} ms reading",
+		stream.residentChunks, stream.capacity, stream.loads, stream.evictions, stream.stalls, stream.stallNs / 1e6,
+		stream.averageLatencyMs(), stream.maxLatencyNs / 1e6, stream.readNs / 1e6) << std::endl;
+
+#if SHOOTER_PROFILING
+	const profiler::Profiler& profile = profiler::Profiler::get();
+	std::cout << std::format("profile of the last {} ticks, us per tick, {} samples dropped:", profile.frames(),
+		profile.droppedSamples()) << std::endl;
+	std::cout << std::format("{:<12}{:>8}{:>8}{:>8}", "phase", "now", "avg", "worst") << std::endl;
+	for (size_t i = 0; i < profiler::PHASES; i++) {
+		const profiler::Phase phase = static_cast<profiler::Phase>(i);
+		const profiler::PhaseStats stats = profile.stats(phase);
+		if (stats.worst == 0) {
+			continue;
+		}
+		const profiler::PhaseInfo& info = profiler::phaseInfo(phase);
+		std::cout << std::format("{:<12}{:>8.1f}{:>8.1f}{:>8.1f}", std::string(info.depth * 2, ' ') + info.name, stats.current / 1e3,
+			stats.average / 1e3, stats.worst / 1e3) << std::endl;
+	}
+#endif
 
-void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos, float scrollFactor,
-	float deltaTime) {
-	scrollPos -= xVelocity * scrollFactor * deltaTime;
+	const bool success = finishInputs(inputs);
+	SDL_Quit();
+	return success ? 0 : 1;
+}
 
-	if (scrollPos <= -texture->w) {
-		scrollPos = 0;
-	}
+// frame times are from the start of a frame to its present, the wall time covers the whole timedemo
+void printTimedemo(std::vector<uint64_t> frameTimes, uint64_t wallNs) {
 
-	SDL_FRect dst{
-		.x = scrollPos, .y = 30,
-		.w = texture->w * 2.0f,
-		.h = static_cast<float>(texture->h)
+	std::sort(frameTimes.begin(), frameTimes.end());
+	const size_t count = frameTimes.size();
+	const auto ms = [](uint64_t ns) { return ns / 1e6; };
+	const auto percentile = [&](double p) {
+		return frameTimes[std::min(static_cast<size_t>(std::ceil(p * count)), count) - 1];
 	};
-
-	SDL_RenderTextureTiled(renderer, texture, nullptr, 1, &dst);
+	uint64_t total = 0;
+	for (uint64_t ns : frameTimes) {
+		total += ns;
+	}
+	std::cout << std::format("timedemo: {} frames in {:.2f} s, {:.1f} fps", count, wallNs / 1e9, count / (wallNs / 1e9)) << std::endl;
+	std::cout << std::format("frame time: avg {:.3f} ms, median {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, worst {:.3f} ms",
+		ms(total / count), ms(percentile(0.5)), ms(percentile(0.95)), ms(percentile(0.99)), ms(frameTimes.back())) << std::endl;
 }
\ No newline at end of file
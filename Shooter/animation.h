@@ -1,22 +1,67 @@
 #pragma once
-#include "timer.h"
+#include <SDL3/SDL.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
-class Animation {
-	Timer timer;
-	int frameCount;
+// Frames of an animation laid out left to right in one texture. Clips never change once built and are
+// shared by everything playing them, which only keeps an AnimationPlayback of its own.
+class AnimationClip {
+	std::vector<float> frameEnds;	// time at which each frame ends, from the start of the clip
+	std::vector<SDL_FRect> frames;	// where each frame is in the texture
 
 public:
-	Animation() : timer(0), frameCount(0) {}
-	Animation(int frameCount, float length) : frameCount(frameCount), timer(length)
+	AnimationClip(const std::vector<float>& durations, float frameWidth, float frameHeight) {
+		float end = 0;
+		for (size_t i = 0; i < durations.size(); i++) {
+			end += durations[i];
+			frameEnds.push_back(end);
+			frames.push_back(SDL_FRect{
+				.x = i * frameWidth,
+				.y = 0,
+				.w = frameWidth,
+				.h = frameHeight
+			});
+		}
+	}
+
+	// frameCount frames of the same duration
+	AnimationClip(int frameCount, float length, float frameWidth, float frameHeight)
+		: AnimationClip(std::vector<float>(frameCount, length / frameCount), frameWidth, frameHeight)
 	{
 	}
 
-	float getLength() const { return timer.getLength(); };
-	int currentFrame() const {
-		return static_cast<int>(timer.getTime() / timer.getLength() * frameCount);
+	float getLength() const { return frameEnds.back(); }
+	int frameCount() const { return static_cast<int>(frames.size()); }
+
+	int frameAt(float time) const {
+		const auto it = std::upper_bound(frameEnds.begin(), frameEnds.end(), time);
+		return std::min(static_cast<int>(it - frameEnds.begin()), frameCount() - 1);
+	}
+
+	const SDL_FRect& frameRect(float time) const { return frames[frameAt(time)]; }
+};
+
+// an object's progress through the clip it plays
+struct AnimationPlayback {
+	int clip = -1;		// -1 for none
+	float time = 0;
+	bool done = false;	// played through at least once
+
+	// switches clips from the start, playing the same clip again carries on with it
+	void play(int clip) {
+		if (clip != this->clip) {
+			this->clip = clip;
+			time = 0;
+			done = false;
+		}
 	}
 
-	void step(float deltaTime) {
-		timer.step(deltaTime);
+	void step(const AnimationClip& clip, float deltaTime) {
+		time += deltaTime;
+		if (time >= clip.getLength()) {
+			time = std::fmod(time, clip.getLength());
+			done = true;
+		}
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Layout of the archive written by AssetPack: a header, a table of contents sorted by name, then the
+// pixels of every image as RGBA32 rows, each blob starting on a 64 byte boundary. Blobs are stored raw
+// so they can be used straight from the mapped file, or run-length encoded when that makes them smaller.
+namespace assetpack {
+	const uint32_t MAGIC = 0x4b504853; // "SHPK"
+	const uint32_t VERSION = 1;
+	const size_t ALIGNMENT = 64;
+
+	enum class Encoding : uint32_t {
+		raw,
+		rle	// (count, pixel) pairs of uint32
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t reserved;
+	};
+
+	struct Entry {
+		char name[64];	// path under the data directory, '/' separated
+		uint32_t width, height, pitch;
+		Encoding encoding;
+		uint64_t offset, size;
+	};
+}
+
+// A packed asset archive mapped into memory. Raw images become surfaces pointing into the mapping, so
+// nothing is copied until the texture upload; run-length encoded ones are decoded into a new surface.
+// The archive has to stay open for as long as any surface made from it.
+class AssetArchive {
+	const uint8_t* data;
+	size_t length;
+	const assetpack::Entry* entries;
+	uint32_t entryCount;
+#ifdef _WIN32
+	HANDLE file, mapping;
+#else
+	int file;
+#endif
+
+	static std::string_view nameOf(const assetpack::Entry& entry) {
+		return std::string_view(entry.name, strnlen(entry.name, sizeof(entry.name)));
+	}
+
+	const assetpack::Entry* find(std::string_view name) const {
+		const assetpack::Entry* end = entries + entryCount;
+		const assetpack::Entry* it = std::lower_bound(entries, end, name, [](const assetpack::Entry& entry, std::string_view name) {
+			return nameOf(entry) < name;
+		});
+		return it != end && nameOf(*it) == name ? it : nullptr;
+	}
+
+	bool isValid(const assetpack::Entry& entry) const {
+		if (entry.offset > length || entry.size > length - entry.offset ||
+			entry.width > INT_MAX / 4 || entry.height > INT_MAX || entry.pitch > INT_MAX) {
+			return false;
+		}
+		switch (entry.encoding) {
+			case assetpack::Encoding::raw:
+				return entry.pitch >= entry.width * 4 && static_cast<uint64_t>(entry.pitch) * entry.height <= entry.size;
+			case assetpack::Encoding::rle:
+				return true;
+		}
+		return false;
+	}
+
+public:
+	AssetArchive() : data(nullptr), length(0), entries(nullptr), entryCount(0),
+#ifdef _WIN32
+		file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#else
+		file(-1)
+#endif
+	{
+	}
+
+	~AssetArchive() { close(); }
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	bool open(const std::string& path) {
+		close();
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			close();
+			return false;
+		}
+		length = static_cast<size_t>(size.QuadPart);
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		data = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+		file = ::open(path.c_str(), O_RDONLY);
+		if (file == -1) {
+			return false;
+		}
+		struct stat info;
+		if (fstat(file, &info) == -1) {
+			close();
+			return false;
+		}
+		length = static_cast<size_t>(info.st_size);
+		void* mapped = length ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+		data = mapped != MAP_FAILED ? static_cast<const uint8_t*>(mapped) : nullptr;
+#endif
+
+		const assetpack::Header* header = reinterpret_cast<const assetpack::Header*>(data);
+		if (!data || length < sizeof(assetpack::Header) || header->magic != assetpack::MAGIC ||
+			header->version != assetpack::VERSION ||
+			length < sizeof(assetpack::Header) + header->entryCount * sizeof(assetpack::Entry)) {
+			close();
+			return false;
+		}
+		entryCount = header->entryCount;
+		entries = reinterpret_cast<const assetpack::Entry*>(data + sizeof(assetpack::Header));
+
+		// a truncated or corrupt archive is rejected here, so surface() never reads past the mapping. find()
+		// searches the table by name, so it has to be sorted without repeats as well
+		for (uint32_t i = 0; i < entryCount; i++) {
+			if (!isValid(entries[i]) || (i > 0 && !(nameOf(entries[i - 1]) < nameOf(entries[i])))) {
+				close();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void close() {
+#ifdef _WIN32
+		if (data) {
+			UnmapViewOfFile(data);
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+		file = INVALID_HANDLE_VALUE;
+		mapping = nullptr;
+#else
+		if (data) {
+			munmap(const_cast<uint8_t*>(data), length);
+		}
+		if (file != -1) {
+			::close(file);
+		}
+		file = -1;
+#endif
+		data = nullptr;
+		length = 0;
+		entries = nullptr;
+		entryCount = 0;
+	}
+
+	bool isOpen() const { return data != nullptr; }
+	bool contains(std::string_view name) const { return find(name) != nullptr; }
+
+	// nullptr if there is no such image. Safe to call from several threads at once
+	SDL_Surface* surface(std::string_view name) const {
+		const assetpack::Entry* entry = find(name);
+		if (!entry) {
+			return nullptr;
+		}
+		const uint8_t* pixels = data + entry->offset;
+		const int w = static_cast<int>(entry->width), h = static_cast<int>(entry->height);
+
+		if (entry->encoding == assetpack::Encoding::raw) {
+			// SDL only reads from it, the mapping itself is read only
+			return SDL_CreateSurfaceFrom(w, h, SDL_PIXELFORMAT_RGBA32, const_cast<uint8_t*>(pixels), static_cast<int>(entry->pitch));
+		}
+
+		SDL_Surface* surface = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_RGBA32);
+		if (!surface) {
+			return nullptr;
+		}
+		const size_t pixelCount = static_cast<size_t>(w) * h;
+		size_t written = 0;
+		for (uint64_t i = 0; i + 8 <= entry->size && written < pixelCount; i += 8) {
+			uint32_t run, pixel;
+			std::memcpy(&run, pixels + i, 4);
+			std::memcpy(&pixel, pixels + i + 4, 4);
+			for (uint32_t n = 0; n < run && written < pixelCount; n++, written++) {
+				uint8_t* row = static_cast<uint8_t*>(surface->pixels) + (written / w) * surface->pitch;
+				std::memcpy(row + (written % w) * 4, &pixel, 4);
+			}
+		}
+		return surface;
+	}
+};
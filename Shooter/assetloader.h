@@ -0,0 +1,112 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "jobsystem.h"
+#include "assetarchive.h"
+#include "profiler.h"
+
+// Decodes image files to surfaces on the job system's workers, one file per job, while the render thread
+// keeps drawing. Turning the surfaces into textures is left to the caller on the render thread. Every
+// asset keeps how long it took to decode so cold starts can be tracked.
+//
+// Assets are named by their path under the data directory. They come out of the packed archive when
+// there is one holding them, otherwise the file is decoded from the loose data directory.
+class AssetLoader {
+	struct Asset {
+		std::string name;
+		SDL_Surface* surface = nullptr;
+		uint64_t decodeNs = 0;
+	};
+
+	struct Decode {
+		AssetLoader* loader;
+
+		void operator()(size_t begin, size_t end) const {
+			for (size_t i = begin; i < end; i++) {
+				PROFILE_SCOPE(decode);
+				Asset& asset = loader->assets[i];
+				const uint64_t start = SDL_GetTicksNS();
+				if (loader->archive && loader->archive->contains(asset.name)) {
+					asset.surface = loader->archive->surface(asset.name);
+				}
+				else {
+					asset.surface = IMG_Load((loader->dataDir + asset.name).c_str());
+				}
+				asset.decodeNs = SDL_GetTicksNS() - start;
+			}
+		}
+	};
+
+	JobSystem& jobs;
+	const AssetArchive* archive;
+	std::string dataDir;
+	std::vector<Asset> assets;
+	Decode decode;
+	std::atomic<size_t> remaining;
+	bool started;
+
+public:
+	// archive may be nullptr or not open, the loose files are looked for under dataDir then
+	AssetLoader(JobSystem& jobs, const AssetArchive* archive, const std::string& dataDir)
+		: jobs(jobs), archive(archive && archive->isOpen() ? archive : nullptr), dataDir(dataDir), decode{ this },
+		remaining(0), started(false)
+	{
+	}
+
+	~AssetLoader() {
+		// the jobs point into this loader
+		jobs.wait(remaining);
+		for (Asset& asset : assets) {
+			SDL_DestroySurface(asset.surface);
+		}
+	}
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// returns the id to take() the surface with, only before start()
+	int add(const std::string& name) {
+		assets.push_back(Asset{ .name = name });
+		return static_cast<int>(assets.size()) - 1;
+	}
+
+	void start() {
+		started = true;
+		jobs.dispatch(assets.size(), 1, decode, remaining);
+	}
+
+	// call on the render thread while waiting, it decodes a file itself when the workers can't keep up.
+	// True once every file is decoded
+	bool update() {
+		if (remaining.load(std::memory_order_acquire) > 0) {
+			jobs.help();
+		}
+		return done();
+	}
+
+	bool done() const { return started && remaining.load(std::memory_order_acquire) == 0; }
+
+	float progress() const {
+		if (assets.empty()) {
+			return 1.0f;
+		}
+		return 1.0f - remaining.load(std::memory_order_acquire) / static_cast<float>(assets.size());
+	}
+
+	size_t size() const { return assets.size(); }
+	const std::string& name(int id) const { return assets[id].name; }
+	bool fromArchive() const { return archive != nullptr; }
+	uint64_t decodeTime(int id) const { return assets[id].decodeNs; }
+
+	// hands the decoded surface over to the caller, nullptr if the file failed to load
+	SDL_Surface* take(int id) {
+		SDL_Surface* surface = assets[id].surface;
+		assets[id].surface = nullptr;
+		return surface;
+	}
+};
@@ -0,0 +1,132 @@
+// assetpack.cpp : Packs the images under a data directory into one archive the game maps at startup.
+//
+// usage: AssetPack <data directory> <archive> [--rle]
+
+#include "assetarchive.h"
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct PackedImage {
+	assetpack::Entry entry;
+	std::vector<uint8_t> bytes;
+};
+
+// (count, pixel) pairs over the pixels in row order
+std::vector<uint8_t> encodeRle(const std::vector<uint8_t>& pixels) {
+	std::vector<uint8_t> out;
+	const size_t count = pixels.size() / 4;
+	for (size_t i = 0; i < count; ) {
+		uint32_t pixel;
+		std::memcpy(&pixel, pixels.data() + i * 4, 4);
+		uint32_t run = 1;
+		while (i + run < count && std::memcmp(pixels.data() + (i + run) * 4, &pixel, 4) == 0) {
+			run++;
+		}
+		const uint8_t* r = reinterpret_cast<const uint8_t*>(&run);
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(&pixel);
+		out.insert(out.end(), r, r + 4);
+		out.insert(out.end(), p, p + 4);
+		i += run;
+	}
+	return out;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		std::cerr << "usage: AssetPack <data directory> <archive> [--rle]" << std::endl;
+		return 1;
+	}
+	const fs::path dataDir = argv[1];
+	const fs::path archivePath = argv[2];
+	const bool rle = argc > 3 && std::string(argv[3]) == "--rle";
+
+	std::vector<std::string> names;
+	for (const fs::directory_entry& file : fs::recursive_directory_iterator(dataDir)) {
+		if (file.is_regular_file() && file.path().extension() == ".png") {
+			names.push_back(fs::relative(file.path(), dataDir).generic_string());
+		}
+	}
+	// the game looks entries up by binary search
+	std::sort(names.begin(), names.end());
+
+	std::vector<PackedImage> images;
+	for (const std::string& name : names) {
+		if (name.size() >= sizeof(assetpack::Entry::name)) {
+			std::cerr << "Name too long: " << name << std::endl;
+			return 1;
+		}
+
+		SDL_Surface* loaded = IMG_Load((dataDir / name).string().c_str());
+		SDL_Surface* surface = loaded ? SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32) : nullptr;
+		SDL_DestroySurface(loaded);
+		if (!surface) {
+			std::cerr << "Failed to load " << name << std::endl;
+			return 1;
+		}
+
+		PackedImage image{};
+		std::memcpy(image.entry.name, name.c_str(), name.size() + 1);
+		image.entry.width = surface->w;
+		image.entry.height = surface->h;
+		image.entry.pitch = surface->w * 4;
+		image.entry.encoding = assetpack::Encoding::raw;
+		for (int y = 0; y < surface->h; y++) {
+			const uint8_t* row = static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch;
+			image.bytes.insert(image.bytes.end(), row, row + image.entry.pitch);
+		}
+		SDL_DestroySurface(surface);
+
+		if (rle) {
+			std::vector<uint8_t> encoded = encodeRle(image.bytes);
+			if (encoded.size() < image.bytes.size()) {
+				image.bytes = std::move(encoded);
+				image.entry.encoding = assetpack::Encoding::rle;
+			}
+		}
+		image.entry.size = image.bytes.size();
+		images.push_back(std::move(image));
+	}
+
+	const auto align = [](uint64_t offset) {
+		return (offset + assetpack::ALIGNMENT - 1) / assetpack::ALIGNMENT * assetpack::ALIGNMENT;
+	};
+	uint64_t offset = align(sizeof(assetpack::Header) + images.size() * sizeof(assetpack::Entry));
+	for (PackedImage& image : images) {
+		image.entry.offset = offset;
+		offset = align(offset + image.entry.size);
+	}
+
+	std::ofstream out(archivePath, std::ios::binary);
+	const assetpack::Header header{
+		.magic = assetpack::MAGIC,
+		.version = assetpack::VERSION,
+		.entryCount = static_cast<uint32_t>(images.size()),
+		.reserved = 0
+	};
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const PackedImage& image : images) {
+		out.write(reinterpret_cast<const char*>(&image.entry), sizeof(image.entry));
+	}
+	for (const PackedImage& image : images) {
+		const std::vector<char> padding(image.entry.offset - static_cast<uint64_t>(out.tellp()), 0);
+		out.write(padding.data(), padding.size());
+		out.write(reinterpret_cast<const char*>(image.bytes.data()), image.bytes.size());
+	}
+	if (!out) {
+		std::cerr << "Failed to write " << archivePath.string() << std::endl;
+		return 1;
+	}
+
+	std::cout << std::format("{} images, {} bytes", images.size(), static_cast<uint64_t>(out.tellp())) << std::endl;
+	return 0;
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+// where an image ended up: the atlas page texture and its rect in there
+struct SpriteRef {
+	SDL_Texture* atlas = nullptr;
+	SDL_FRect rect{};
+};
+
+// Packs images into as few square pages as it can at load time, so everything drawn from one page can
+// go in a single batch. Images are added as surfaces, pack() lays them out tallest first with a skyline
+// packer and frees them, then upload() turns each page into a texture. An image too big for a page gets
+// a page of its own.
+class TextureAtlas {
+	// the top edge of what has been packed so far, left to right
+	struct Segment {
+		int x, y, w;
+	};
+
+	struct Page {
+		int w, h;
+		std::vector<Segment> skyline;
+		SDL_Surface* surface;
+	};
+
+	struct Image {
+		SDL_Surface* surface;
+		int page;
+		SDL_Rect rect;
+	};
+
+	std::vector<Image> images;
+	std::vector<Page> pages;
+	std::vector<SDL_Texture*> textures;
+	int pageSize, padding;
+
+	// lowest spot along the skyline that fits w x h, leftmost on a tie
+	static bool findSpot(const Page& page, int w, int h, int& bestIndex, int& bestX, int& bestY) {
+		bestIndex = -1;
+		for (size_t i = 0; i < page.skyline.size(); i++) {
+			const int x = page.skyline[i].x;
+			if (x + w > page.w) {
+				break;
+			}
+			int y = 0;
+			for (size_t j = i; j < page.skyline.size() && page.skyline[j].x < x + w; j++) {
+				y = std::max(y, page.skyline[j].y);
+			}
+			if (y + h <= page.h && (bestIndex == -1 || y < bestY)) {
+				bestIndex = static_cast<int>(i);
+				bestX = x;
+				bestY = y;
+			}
+		}
+		return bestIndex != -1;
+	}
+
+	static void place(Page& page, int index, int x, int y, int w, int h) {
+		std::vector<Segment>& skyline = page.skyline;
+		skyline.insert(skyline.begin() + index, Segment{ x, y + h, w });
+
+		// the segments now covered shrink or go away
+		for (size_t i = index + 1; i < skyline.size(); ) {
+			Segment& segment = skyline[i];
+			const int covered = x + w - segment.x;
+			if (covered <= 0) {
+				break;
+			}
+			if (covered < segment.w) {
+				segment.x += covered;
+				segment.w -= covered;
+				break;
+			}
+			skyline.erase(skyline.begin() + i);
+		}
+
+		// neighbours at the same height become one
+		for (size_t i = 0; i + 1 < skyline.size(); ) {
+			if (skyline[i].y == skyline[i + 1].y) {
+				skyline[i].w += skyline[i + 1].w;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else {
+				i++;
+			}
+		}
+	}
+
+	int addPage(int w, int h) {
+		pages.push_back(Page{ .w = w, .h = h, .skyline = { Segment{ 0, 0, w } }, .surface = nullptr });
+		return static_cast<int>(pages.size()) - 1;
+	}
+
+public:
+	TextureAtlas(int pageSize = 1024, int padding = 1) : pageSize(pageSize), padding(padding) {}
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// takes ownership of surface, returns the id to get() its SpriteRef with once built
+	int add(SDL_Surface* surface) {
+		images.push_back(Image{ .surface = surface, .page = -1, .rect = { 0, 0, 0, 0 } });
+		return static_cast<int>(images.size()) - 1;
+	}
+
+	// lays out and copies the images onto page surfaces, upload() each page before get()
+	bool pack() {
+		std::vector<size_t> order(images.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			const int ha = images[a].surface ? images[a].surface->h : 0;
+			const int hb = images[b].surface ? images[b].surface->h : 0;
+			return ha > hb;
+		});
+
+		for (size_t i : order) {
+			Image& image = images[i];
+			if (!image.surface) {
+				continue;
+			}
+			const int w = image.surface->w + padding;
+			const int h = image.surface->h + padding;
+
+			int index = -1, x = 0, y = 0;
+			for (size_t p = 0; p < pages.size() && image.page == -1; p++) {
+				if (findSpot(pages[p], w, h, index, x, y)) {
+					image.page = static_cast<int>(p);
+				}
+			}
+			if (image.page == -1) {
+				image.page = addPage(std::max(pageSize, w), std::max(pageSize, h));
+				findSpot(pages[image.page], w, h, index, x, y);
+			}
+			place(pages[image.page], index, x, y, w, h);
+			image.rect = SDL_Rect{ x, y, image.surface->w, image.surface->h };
+		}
+
+		bool success = true;
+		for (Page& page : pages) {
+			page.surface = SDL_CreateSurface(page.w, page.h, SDL_PIXELFORMAT_RGBA32);
+			if (!page.surface) {
+				success = false;
+			}
+		}
+		for (Image& image : images) {
+			if (image.surface && pages[image.page].surface) {
+				// copy the alpha as is instead of blending onto the empty page
+				SDL_SetSurfaceBlendMode(image.surface, SDL_BLENDMODE_NONE);
+				SDL_BlitSurface(image.surface, nullptr, pages[image.page].surface, &image.rect);
+			}
+			SDL_DestroySurface(image.surface);
+			image.surface = nullptr;
+		}
+		textures.assign(pages.size(), nullptr);
+		return success;
+	}
+
+	// makes the texture for one packed page and frees its surface
+	bool upload(SDL_Renderer* renderer, size_t page) {
+		Page& p = pages[page];
+		SDL_Texture* texture = p.surface ? SDL_CreateTextureFromSurface(renderer, p.surface) : nullptr;
+		if (texture) {
+			SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+		}
+		textures[page] = texture;
+		SDL_DestroySurface(p.surface);
+		p.surface = nullptr;
+		return texture != nullptr;
+	}
+
+	// an empty ref for images that failed to load
+	SpriteRef get(int id) const {
+		const Image& image = images[id];
+		if (image.page == -1 || !textures[image.page]) {
+			return SpriteRef();
+		}
+		return SpriteRef{
+			.atlas = textures[image.page],
+			.rect = {
+				.x = static_cast<float>(image.rect.x),
+				.y = static_cast<float>(image.rect.y),
+				.w = static_cast<float>(image.rect.w),
+				.h = static_cast<float>(image.rect.h)
+			}
+		};
+	}
+
+	size_t pageCount() const { return pages.size(); }
+
+	void unload() {
+		for (SDL_Texture* texture : textures) {
+			SDL_DestroyTexture(texture);
+		}
+		textures.clear();
+	}
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include "ecs.h"
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+template<typename R>
+class CommandBuffer;
+
+// Records structural changes to a registry while it is being iterated, possibly from several threads
+// (one buffer per thread), and applies them at a sync point in phases that run across every buffer:
+// applySpawns() on all of them, then applyWrites() on all of them, then the destroys that takeDestroys()
+// collects from all of them, sorted so that which thread recorded what doesn't matter. A write never
+// lands on an entity another buffer destroyed, writes to entities dead already are dropped.
+//
+// spawn() hands out a placeholder entity that set() and destroy() accept; it becomes a real entity in
+// applySpawns(), and means nothing to any other buffer. Destroyed entities leave their rows dead until
+// Registry::compact(). Buffers keep their storage between ticks, so recording allocates nothing once
+// they have warmed up.
+template<typename... Components>
+class CommandBuffer<Registry<Components...>> {
+	// placeholders carry this generation, their index counts the spawns
+	static const uint32_t PENDING = UINT32_MAX;
+
+	template<typename C>
+	struct Writes {
+		std::vector<std::pair<Entity, C>> values;
+		size_t count = 0;
+	};
+
+	std::tuple<Writes<Components>...> writes;
+	std::vector<Entity> destroys;
+	std::vector<Entity> spawned;
+	uint32_t spawnCount;
+
+	Entity resolve(Entity e) const {
+		return e.generation == PENDING ? spawned[e.index] : e;
+	}
+
+public:
+	CommandBuffer() : spawnCount(0) {}
+
+	Entity spawn() {
+		return Entity{ spawnCount++, PENDING };
+	}
+
+	template<typename C>
+	void set(Entity e, const C& value) {
+		Writes<C>& w = std::get<Writes<C>>(writes);
+		// overwrite slots left from the last tick so whatever they own is reused
+		if (w.count < w.values.size()) {
+			w.values[w.count].first = e;
+			w.values[w.count].second = value;
+		}
+		else {
+			w.values.emplace_back(e, value);
+		}
+		w.count++;
+	}
+
+	void destroy(Entity e) {
+		destroys.push_back(e);
+	}
+
+	// room for n spawns, destroys and writes of every component before anything has to grow
+	void reserve(size_t n) {
+		std::apply([n](auto&... w) { (w.values.reserve(n), ...); }, writes);
+		destroys.reserve(n);
+		spawned.reserve(n);
+	}
+
+	bool empty() const {
+		return spawnCount == 0 && destroys.empty() &&
+			std::apply([](const auto&... w) { return ((w.count == 0) && ...); }, writes);
+	}
+
+	void applySpawns(Registry<Components...>& registry) {
+		spawned.clear();
+		for (uint32_t i = 0; i < spawnCount; i++) {
+			spawned.push_back(registry.create());
+		}
+	}
+
+	// in the order they were recorded, after every buffer's spawns
+	void applyWrites(Registry<Components...>& registry) {
+		std::apply([this, &registry](auto&... w) {
+			([&] {
+				for (size_t i = 0; i < w.count; i++) {
+					const Entity e = resolve(w.values[i].first);
+					if (registry.alive(e)) {
+						registry.add(e, w.values[i].second);
+					}
+				}
+				w.count = 0;
+			}(), ...);
+		}, writes);
+	}
+
+	// appends the entities to destroy to out with placeholders resolved, after every buffer's writes.
+	// The buffer is empty afterwards
+	void takeDestroys(std::vector<Entity>& out) {
+		for (Entity e : destroys) {
+			out.push_back(resolve(e));
+		}
+		destroys.clear();
+		spawnCount = 0;
+	}
+};
@@ -0,0 +1,245 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include <functional>
+#include <compare>
+#include <cassert>
+
+// A handle to an entity. The index picks a slot in the registry, the generation has to match the slot's,
+// so a handle to a destroyed entity never reaches whatever reuses the slot later.
+struct Entity {
+	uint32_t index;
+	uint32_t generation;
+
+	bool operator==(const Entity&) const = default;
+	auto operator<=>(const Entity&) const = default;
+};
+const Entity NULL_ENTITY{ UINT32_MAX, UINT32_MAX };
+
+// Entities stored as structure-of-arrays: one contiguous column per component type, one row per entity.
+// A bit mask per row records which components the entity actually has. The component set is fixed at
+// compile time, so looking up a column or building a view's mask never happens at runtime.
+//
+// Handles go through a slot table to find their row, so rows can move. destroy() only marks the row
+// dead; compact() then swap-and-pops the dead rows, highest first, keeping the live ones packed at the
+// front. Popped rows keep their values past the end and create() takes them over, so storage owned by
+// a component is reused. Freed slots are handed out last freed first, so creating and destroying are
+// O(1); the handles created only come out the same on every run if the destroys before them came in the
+// same order, which is why CommandBuffer destroys are sorted before they are applied.
+//
+// Creating entities may reallocate the columns and compacting moves rows, don't do either while
+// iterating a view. Destroying is fine.
+template<typename... Components>
+class Registry {
+	static_assert(sizeof...(Components) <= 32, "component masks are 32 bits");
+
+	struct Slot {
+		uint32_t row;
+		uint32_t generation;
+	};
+
+	std::tuple<std::vector<Components>...> columns;
+	std::vector<uint32_t> masks;
+	std::vector<Entity> entities;	// the handle owning each row
+	uint32_t rowCount;
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<uint32_t> deadRows;
+
+	template<typename C, typename First, typename... Rest>
+	static constexpr uint32_t indexOf() {
+		if constexpr (std::is_same_v<C, First>) {
+			return 0;
+		}
+		else {
+			static_assert(sizeof...(Rest) > 0, "type is not a component of this registry");
+			return 1 + indexOf<C, Rest...>();
+		}
+	}
+
+	uint32_t rowOf(Entity e) const {
+		assert(alive(e));
+		return slots[e.index].row;
+	}
+
+public:
+	template<typename C>
+	static constexpr uint32_t bit() { return 1u << indexOf<C, Components...>(); }
+
+	template<typename... Cs>
+	static constexpr uint32_t maskOf() { return (0u | ... | bit<Cs>()); }
+
+	// iterates every entity having all of Cs, yielding (entity, Cs&...)
+	template<typename... Cs>
+	class View {
+		std::tuple<Cs*...> data;
+		const uint32_t* masks;
+		const Entity* entities;
+		uint32_t count;
+
+	public:
+		class Iterator {
+			const View* view;
+			uint32_t row;
+
+			void skip() {
+				while (row < view->count && (view->masks[row] & maskOf<Cs...>()) != maskOf<Cs...>()) {
+					row++;
+				}
+			}
+
+		public:
+			Iterator(const View* view, uint32_t row) : view(view), row(row) { skip(); }
+
+			std::tuple<Entity, Cs&...> operator*() const {
+				return std::tuple<Entity, Cs&...>(view->entities[row], std::get<Cs*>(view->data)[row]...);
+			}
+
+			Iterator& operator++() {
+				row++;
+				skip();
+				return *this;
+			}
+
+			bool operator!=(const Iterator& other) const { return row != other.row; }
+		};
+
+		View(Registry& registry)
+			: data(registry.template column<Cs>().data()...), masks(registry.masks.data()),
+			entities(registry.entities.data()), count(registry.rowCount)
+		{
+		}
+
+		Iterator begin() const { return Iterator(this, 0); }
+		Iterator end() const { return Iterator(this, count); }
+
+		// number of rows the view spans
+		size_t size() const { return count; }
+
+		template<typename Fn>
+		void each(Fn&& fn) const {
+			each(0, count, fn);
+		}
+
+		// only the rows in [first, last), so a view can be split into ranges across jobs
+		template<typename Fn>
+		void each(size_t first, size_t last, Fn&& fn) const {
+			for (uint32_t row = static_cast<uint32_t>(first); row < last; row++) {
+				if ((masks[row] & maskOf<Cs...>()) == maskOf<Cs...>()) {
+					fn(entities[row], std::get<Cs*>(data)[row]...);
+				}
+			}
+		}
+	};
+
+	Registry() : rowCount(0) {}
+
+	Entity create() {
+		uint32_t index;
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			index = static_cast<uint32_t>(slots.size());
+			slots.push_back(Slot{ 0, 0 });
+		}
+
+		if (rowCount == masks.size()) {
+			std::apply([](auto&... column) { (column.emplace_back(), ...); }, columns);
+			masks.push_back(0);
+			entities.push_back(NULL_ENTITY);
+		}
+
+		const uint32_t row = rowCount++;
+		const Entity e{ index, slots[index].generation };
+		slots[index].row = row;
+		masks[row] = 0;
+		entities[row] = e;
+		return e;
+	}
+
+	void destroy(Entity e) {
+		if (!alive(e)) {
+			return;
+		}
+		Slot& slot = slots[e.index];
+		masks[slot.row] = 0;
+		entities[slot.row] = NULL_ENTITY;
+		deadRows.push_back(slot.row);
+		slot.generation++;
+		freeSlots.push_back(e.index);
+	}
+
+	// moves the last live row into every hole left by destroy()
+	void compact() {
+		std::sort(deadRows.begin(), deadRows.end(), std::greater<uint32_t>());
+		for (uint32_t row : deadRows) {
+			// every dead row above this one is gone already, so the last row is live
+			const uint32_t last = --rowCount;
+			if (row != last) {
+				std::apply([row, last](auto&... column) { (std::swap(column[row], column[last]), ...); }, columns);
+				std::swap(masks[row], masks[last]);
+				std::swap(entities[row], entities[last]);
+				slots[entities[row].index].row = row;
+			}
+		}
+		deadRows.clear();
+	}
+
+	void reserve(size_t capacity) {
+		std::apply([capacity](auto&... column) { (column.reserve(capacity), ...); }, columns);
+		masks.reserve(capacity);
+		entities.reserve(capacity);
+		slots.reserve(capacity);
+		freeSlots.reserve(capacity);
+		deadRows.reserve(capacity);
+	}
+
+	bool alive(Entity e) const {
+		return e.index < slots.size() && slots[e.index].generation == e.generation;
+	}
+
+	// number of rows, including dead ones not compacted yet
+	size_t size() const { return rowCount; }
+	size_t alive() const { return rowCount - deadRows.size(); }
+
+	template<typename C>
+	C& add(Entity e, const C& value) {
+		const uint32_t row = rowOf(e);
+		masks[row] |= bit<C>();
+		return column<C>()[row] = value;
+	}
+
+	template<typename C>
+	bool has(Entity e) const { return alive(e) && (masks[slots[e.index].row] & bit<C>()) != 0; }
+
+	template<typename C>
+	C& get(Entity e) { return column<C>()[rowOf(e)]; }
+
+	template<typename C>
+	const C& get(Entity e) const { return column<C>()[rowOf(e)]; }
+
+	template<typename C>
+	std::vector<C>& column() { return std::get<std::vector<C>>(columns); }
+
+	template<typename C>
+	const std::vector<C>& column() const { return std::get<std::vector<C>>(columns); }
+
+	template<typename... Cs>
+	View<Cs...> view() { return View<Cs...>(*this); }
+
+	template<typename... Cs>
+	size_t count() const {
+		size_t n = 0;
+		for (uint32_t row = 0; row < rowCount; row++) {
+			n += (masks[row] & maskOf<Cs...>()) == maskOf<Cs...>();
+		}
+		return n;
+	}
+};
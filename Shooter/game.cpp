@@ -0,0 +1,763 @@
+﻿// game.cpp : Simulation and drawing of the game, main() and the headless runner are in Shooter.cpp.
+//
+
+#include "game.h"
+#include <algorithm>
+#include <cmath>
+
+// returns false without drawing when the object is out of view
+bool drawObject(const SDLState&, GameState& gameState, const Resources& resources, const Position& pos, const Body& body,
+	const Sprite& sprite, float alpha) {
+
+	// draw in between the last two simulation ticks
+	const glm::vec2 position = glm::mix(pos.prev, pos.value, alpha);
+
+	const SDL_FRect& view = gameState.mapViewport;
+	if (position.x + sprite.width < view.x - CULL_MARGIN || position.x > view.x + view.w + CULL_MARGIN ||
+		position.y + sprite.height < view.y - CULL_MARGIN || position.y > view.y + view.h + CULL_MARGIN) {
+		return false;
+	}
+
+	// clip frames are relative to the sheet
+	SDL_FRect src = sprite.animation.clip != -1 ?
+		resources.clips[sprite.animation.clip].frameRect(sprite.animation.time) :
+		SDL_FRect{ .x = 0, .y = 0, .w = sprite.width, .h = sprite.height };
+	src.x += sprite.sheet.rect.x;
+	src.y += sprite.sheet.rect.y;
+
+	SDL_FRect dst{
+		.x = position.x - gameState.mapViewport.x ,
+		.y = position.y,
+		.w = sprite.width,
+		.h = sprite.height
+	};
+
+	SDL_FlipMode flipMode = body.direction == -1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+
+	gameState.sprites.draw(sprite.sheet.atlas, src, dst, flipMode);
+	return true;
+}
+
+void drawTiles(const SDLState& state, GameState& gameState, const Resources& resources, TileChunks& chunks) {
+
+	// only the chunks in view, any of them whose tiles changed is baked again first
+	const int drawn = chunks.draw(state.renderer, gameState.sprites, resources.tileSprites, gameState.mapViewport, CULL_MARGIN);
+	gameState.drawnCount += drawn;
+	gameState.culledCount += static_cast<int>(chunks.chunkCount()) - drawn;
+}
+
+void drawOverlay(const SDLState& state, GameState& gameState) {
+
+	const World& world = gameState.world;
+	SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+	SDL_RenderDebugText(state.renderer, 5, 5,
+		std::format("State: {}, Pairs: {}, Bodies: {}/{}/{}, Draws: {} for {} sprites", static_cast<int>(world.get<PlayerData>(gameState.player).state),
+			gameState.pairTests, gameState.bodyCounts[0], gameState.bodyCounts[1], gameState.bodyCounts[2],
+			gameState.sprites.getDrawCalls(), gameState.sprites.getQuads()).c_str());
+	SDL_RenderDebugText(state.renderer, 5, 15,
+		std::format("Drawn: {}, Culled: {}", gameState.drawnCount, gameState.culledCount).c_str());
+	const WorldStream::Stats& stream = gameState.stream.getStats();
+	SDL_RenderDebugText(state.renderer, 5, 25,
+		std::format("Chunks: {}/{}, Loads: {}, Evicted: {}, Latency: {:.1f}/{:.1f} ms, Stalls: {}", stream.residentChunks,
+			stream.capacity, stream.loads, stream.evictions, stream.averageLatencyMs(), stream.maxLatencyNs / 1e6,
+			stream.stalls).c_str());
+
+#if SHOOTER_PROFILING
+	// every phase over the last frames, then the frame times as a graph with a line at 60 fps
+	const profiler::Profiler& profile = profiler::Profiler::get();
+	const auto ms = [](uint64_t ns) { return ns / 1e6; };
+	float y = 40;
+	SDL_RenderDebugText(state.renderer, 5, y, std::format("{:<12}{:>8}{:>8}{:>8}  ms, {} frames, {} samples dropped", "phase", "now",
+		"avg", "worst", profile.frames(), profile.droppedSamples()).c_str());
+	for (size_t i = 0; i < profiler::PHASES; i++) {
+		// phases that didn't run lately, like loading, are left out
+		const profiler::Phase phase = static_cast<profiler::Phase>(i);
+		const profiler::PhaseStats stats = profile.stats(phase);
+		if (stats.worst == 0) {
+			continue;
+		}
+		const profiler::PhaseInfo& info = profiler::phaseInfo(phase);
+		y += 10;
+		SDL_RenderDebugText(state.renderer, 5, y, std::format("{:<12}{:>8.2f}{:>8.2f}{:>8.2f}", std::string(info.depth * 2, ' ') + info.name,
+			ms(stats.current), ms(stats.average), ms(stats.worst)).c_str());
+	}
+
+	const float graphHeight = 60;
+	const float msHeight = graphHeight / 33.3f;
+	const SDL_FRect graph{ .x = 5, .y = y + 15, .w = static_cast<float>(profiler::HISTORY), .h = graphHeight };
+	std::array<SDL_FPoint, profiler::HISTORY> points;
+	const size_t frames = profile.frames();
+	for (size_t age = 0; age < frames; age++) {
+		const float height = std::min(static_cast<float>(ms(profile.frameTime(age))) * msHeight, graphHeight);
+		points[age] = SDL_FPoint{ .x = graph.x + graph.w - 1 - age, .y = graph.y + graph.h - height };
+	}
+	SDL_RenderRect(state.renderer, &graph);
+	SDL_RenderLines(state.renderer, points.data(), static_cast<int>(frames));
+	SDL_SetRenderDrawColor(state.renderer, 255, 80, 80, 255);
+	const float target = graph.y + graph.h - 16.7f * msHeight;
+	SDL_RenderLine(state.renderer, graph.x, target, graph.x + graph.w, target);
+#endif
+}
+
+SDL_FRect colliderRect(const Position& pos, const Collider& collider) {
+	return SDL_FRect{
+		.x = pos.value.x + collider.rect.x,
+		.y = pos.value.y + collider.rect.y,
+		.w = collider.rect.w,
+		.h = collider.rect.h
+	};
+}
+
+void simulate(const SDLState& state, GameState& gameState, Resources& resources, float deltaTime) {
+
+	World& world = gameState.world;
+
+	// remember where everything was so drawing can interpolate between ticks
+	const auto moving = world.view<Position, Body>();
+	gameState.jobs.parallelFor(moving.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+		moving.each(begin, end, [](Entity, Position& pos, Body& body) {
+			if (body.type != BodyType::stationary) {
+				pos.prev = pos.value;
+			}
+		});
+	});
+
+	// rebuild the broadphase from where everything starts this tick.
+	// Bullets are never collided against, so they stay out of it
+	gameState.broadphase.clear();
+	for (auto [e, pos, collider] : world.view<Position, Collider>()) {
+		if (!world.has<BulletData>(e)) {
+			gameState.broadphase.insert(colliderRect(pos, collider), e);
+		}
+	}
+
+	//player input and state
+	for (auto [e, player] : world.view<PlayerData>()) {
+		updatePlayer(state, gameState, resources, e, deltaTime);
+	}
+
+	//spawn the bullets fired this tick, they move from the next pass on
+	applyCommands(gameState);
+
+	//bullets stop where they strike, before anything moves
+	{
+		PROFILE_SCOPE(bullets);
+		sweepBullets(gameState, deltaTime);
+		applyBulletHits(gameState, resources);
+	}
+
+	integrate(gameState, deltaTime);
+	collide(state, gameState, resources, deltaTime);
+
+	//update the animations
+	const auto sprites = world.view<Sprite>();
+	gameState.jobs.parallelFor(sprites.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+		sprites.each(begin, end, [&resources, deltaTime](Entity, Sprite& sprite) {
+			if (sprite.animation.clip != -1) {
+				sprite.animation.step(resources.clips[sprite.animation.clip], deltaTime);
+			}
+		});
+	});
+
+	{
+		PROFILE_SCOPE(bullets);
+		updateBullets(gameState, deltaTime);
+		applyCommands(gameState);
+	}
+
+	// gather the counters the workers kept
+	for (WorkerScratch& scratch : gameState.scratch) {
+		gameState.pairTests += scratch.pairTests;
+		for (size_t i = 0; i < scratch.bodyCounts.size(); i++) {
+			gameState.bodyCounts[i] += scratch.bodyCounts[i];
+		}
+		scratch.pairTests = 0;
+		scratch.bodyCounts = {};
+	}
+}
+
+void updatePlayer(const SDLState&, GameState& gameState, Resources& resources, Entity e, float deltaTime) {
+
+	World& world = gameState.world;
+	PlayerData& player = world.get<PlayerData>(e);
+	Body& body = world.get<Body>(e);
+	Sprite& sprite = world.get<Sprite>(e);
+	glm::vec2& velocity = world.get<Velocity>(e).value;
+	const glm::vec2& position = world.get<Position>(e).value;
+
+	float currentDirection = 0;
+
+	if (gameState.input.isHeld(Button::left)) {
+		currentDirection += -1;
+	}
+
+	if (gameState.input.isHeld(Button::right)) {
+		currentDirection += 1;
+	}
+
+	if (currentDirection) {
+		body.direction = currentDirection;
+	}
+
+	Timer& weaponTimer = player.weaponTimer;
+	weaponTimer.step(deltaTime);
+
+	switch (player.state) {
+
+		case PlayerState::idle: {
+			// switching to running state
+			if (currentDirection) {
+				player.state = PlayerState::running;
+			}
+			else {
+				if (velocity.x) {
+					const float factor = velocity.x > 0 ? -1.5f : 1.5f;
+					float amount = factor * body.acceleration.x * deltaTime;
+					if (std::abs(velocity.x) < std::abs(amount)) {
+						velocity.x = 0;
+					}
+					else {
+						velocity.x += amount;
+					}
+				}
+			}
+			if (gameState.input.isHeld(Button::fire)) {
+
+				if (weaponTimer.isTimeout()) {
+					weaponTimer.reset();
+
+					//spawn some bullets
+					const float left = 4;
+					const float right = 24;
+					const float t = (body.direction + 1) / 2.0f;
+					const float xOffset = left + right * t;
+
+					// once the pool is exhausted the shot is dropped
+					if (gameState.bulletCount < MAX_BULLETS) {
+						CommandBuffer<World>& commands = gameState.workerScratch().commands;
+						const glm::vec2 spawnPos(position.x + xOffset, position.y + TILE_SIZE / 2 + 1);
+						Entity bullet = commands.spawn();
+						commands.set(bullet, ObjectType::bullet);
+						commands.set(bullet, Position{ .value = spawnPos, .prev = spawnPos });
+						commands.set(bullet, Velocity{ .value = glm::vec2(velocity.x + 600.0f * body.direction, 0) });
+						commands.set(bullet, Body{ .type = BodyType::kinematic, .direction = body.direction });
+						commands.set(bullet, Collider{ .rect = { .x = 0, .y = 0, .w = BULLET_SIZE, .h = BULLET_SIZE } });
+						commands.set(bullet, resources.bulletSprite);
+						commands.set(bullet, BulletData());
+						gameState.bulletCount++;
+					}
+				}
+
+			}
+			sprite.sheet = resources.sprIdle;
+			sprite.animation.play(resources.ANIM_PLAYER_IDLE);
+			break;
+		}
+		
+		case PlayerState::running: {
+			if (!currentDirection) {
+				player.state = PlayerState::idle;
+
+			}
+
+			// moving in opposite direction of velocity, sliding !
+			if (velocity.x * body.direction < 0 && body.grounded) {
+				sprite.sheet = resources.sprSlide;
+				sprite.animation.play(resources.ANIM_PLAYER_SLIDING);
+			}
+			else {
+				sprite.sheet = resources.sprRun;
+				sprite.animation.play(resources.ANIM_PLAYER_RUN);
+			}
+			
+			break;
+		}
+
+		case PlayerState::jumping: {
+			sprite.sheet = resources.sprRun;
+			sprite.animation.play(resources.ANIM_PLAYER_RUN);
+		}
+	}
+
+	//add acceleration to velocity
+	velocity += currentDirection * body.acceleration * deltaTime;
+	if (std::abs(velocity.x) > body.maxSpeedX) {
+		velocity.x = currentDirection * body.maxSpeedX;
+	}
+}
+
+void integrate(GameState& gameState, float deltaTime) {
+
+	const auto bodies = gameState.world.view<Position, Velocity, Body>();
+	gameState.jobs.parallelFor(bodies.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+
+		// timed per job, on whichever thread runs it
+		PROFILE_SCOPE(integrate);
+		WorkerScratch& scratch = gameState.workerScratch();
+		bodies.each(begin, end, [&](Entity, Position& pos, Velocity& vel, Body& body) {
+
+			//stationary bodies are only collided against
+			scratch.bodyCounts[static_cast<size_t>(body.type)]++;
+			if (body.type == BodyType::stationary) {
+				return;
+			}
+
+			if (body.type == BodyType::dynamic) {
+				//apply some gravity
+				vel.value += glm::vec2(0, 500) * deltaTime;
+			}
+
+			//add velocity to position
+			pos.value += vel.value * deltaTime;
+		});
+	});
+}
+
+void collide(const SDLState& state, GameState& gameState, Resources& resources, float deltaTime) {
+
+	PROFILE_SCOPE(collide);
+	World& world = gameState.world;
+	for (auto [e, pos, vel, body, collider] : world.view<Position, Velocity, Body, Collider>()) {
+
+		// bullets were swept before moving
+		if (body.type == BodyType::stationary || world.has<BulletData>(e)) {
+			continue;
+		}
+
+		//handle collision detection against nearby objects, the bounds include the grounded sensor
+		SDL_FRect bounds = colliderRect(pos, collider);
+		bounds.h += 1;
+		WorkerScratch& scratch = gameState.workerScratch();
+		std::vector<Entity>& candidates = scratch.candidates;
+		candidates.clear();
+		gameState.broadphase.query(bounds, candidates);
+
+		const bool isPlayer = world.get<ObjectType>(e) == ObjectType::player;
+		bool foundGround = false;
+		gameState.level.forEachOverlapping(bounds, [&](int r, int c, uint16_t) {
+			scratch.pairTests++;
+			const SDL_FRect rectA = colliderRect(pos, collider);
+			const SDL_FRect rectB = gameState.level.cellRect(r, c);
+			SDL_FRect rectC{};
+			if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC) && isPlayer) {
+				levelCollisionResponse(pos, vel, rectC);
+			}
+
+			//grounded sensor
+			const SDL_FRect sensor{
+				.x = pos.value.x + collider.rect.x,
+				.y = pos.value.y + collider.rect.y + collider.rect.h,
+				.w = collider.rect.w,
+				.h = 1
+			};
+			if (SDL_HasRectIntersectionFloat(&sensor, &rectB)) {
+				foundGround = true;
+			}
+		});
+
+		for (Entity other : candidates) {
+			if (other != e) {
+				scratch.pairTests++;
+				checkCollissions(state, gameState, resources, e, other, deltaTime);
+
+				//grounded sensor
+				SDL_FRect sensor{
+					.x = pos.value.x + collider.rect.x,
+					.y = pos.value.y + collider.rect.y + collider.rect.h,
+					.w = collider.rect.w,
+					.h = 1
+				};
+
+				const SDL_FRect rectB = colliderRect(world.get<Position>(other), world.get<Collider>(other));
+				if (SDL_HasRectIntersectionFloat(&sensor, &rectB)) {
+					foundGround = true;
+				}
+			}
+		}
+
+		if (body.grounded != foundGround) {
+			// switching grounded state
+			body.grounded = foundGround;
+			if (foundGround && isPlayer) {
+				world.get<PlayerData>(e).state = PlayerState::running;
+			}
+		}
+	}
+}
+
+void bulletHit(GameState& gameState, Resources& resources, Entity e) {
+
+	World& world = gameState.world;
+	BulletData& bullet = world.get<BulletData>(e);
+	if (bullet.state == BulletState::moving) {
+		// stop and play the hit animation, updateBullets retires it afterwards
+		bullet.state = BulletState::colliding;
+		world.get<Velocity>(e).value = glm::vec2(0);
+		Sprite& sprite = world.get<Sprite>(e);
+		sprite.sheet = resources.sprBulletHit;
+		sprite.animation.play(resources.ANIM_BULLET_HIT);
+	}
+}
+
+void sweepBullets(GameState& gameState, float deltaTime) {
+
+	World& world = gameState.world;
+
+	// only reads the world, every worker collects its hits to be resolved afterwards in one go
+	const auto bullets = world.view<BulletData, Position, Velocity, Collider>();
+	gameState.jobs.parallelFor(bullets.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+
+		WorkerScratch& scratch = gameState.workerScratch();
+		bullets.each(begin, end, [&](Entity e, BulletData& bullet, Position& pos, Velocity& vel, Collider& collider) {
+
+			if (bullet.state != BulletState::moving) {
+				return;
+			}
+
+			const SDL_FRect box = colliderRect(pos, collider);
+			const glm::vec2 delta = vel.value * deltaTime;
+			BulletHit hit{ .bullet = e, .target = NULL_ENTITY, .time = 2, .point = glm::vec2(0) };
+
+			SweepHit sweep;
+			if (gameState.level.sweep(box, delta, sweep)) {
+				hit.time = sweep.time;
+			}
+
+			std::vector<Entity>& candidates = scratch.candidates;
+			candidates.clear();
+			gameState.broadphase.query(sweptBounds(box, delta), candidates);
+			for (Entity other : candidates) {
+				if (world.get<ObjectType>(other) == ObjectType::enemy) {
+					scratch.pairTests++;
+					const SDL_FRect target = colliderRect(world.get<Position>(other), world.get<Collider>(other));
+					if (sweepAABB(box, delta, target, sweep) && sweep.time < hit.time) {
+						hit.time = sweep.time;
+						hit.target = other;
+					}
+				}
+			}
+
+			if (hit.time <= 1) {
+				hit.point = pos.value + delta * hit.time;
+				scratch.bulletHits.push_back(hit);
+			}
+		});
+	});
+}
+
+void applyBulletHits(GameState& gameState, Resources& resources) {
+
+	for (WorkerScratch& scratch : gameState.scratch) {
+		for (const BulletHit& hit : scratch.bulletHits) {
+			gameState.world.get<Position>(hit.bullet).value = hit.point;
+			bulletHit(gameState, resources, hit.bullet);
+		}
+		scratch.bulletHits.clear();
+	}
+}
+
+void updateBullets(GameState& gameState, float deltaTime) {
+
+	World& world = gameState.world;
+	const SDL_FRect& view = gameState.mapViewport;
+	const float margin = TILE_SIZE;
+
+	const auto bullets = world.view<BulletData, Position, Sprite>();
+	gameState.jobs.parallelFor(bullets.size(), JOB_GRAIN, [&](size_t begin, size_t end) {
+
+		WorkerScratch& scratch = gameState.workerScratch();
+		bullets.each(begin, end, [&](Entity e, BulletData& bullet, Position& pos, Sprite& sprite) {
+
+			switch (bullet.state) {
+				case BulletState::moving: {
+					// gone once it leaves the screen or has been flying for too long
+					bullet.age += deltaTime;
+					const bool offscreen = pos.value.x + BULLET_SIZE < view.x - margin || pos.value.x > view.x + view.w + margin ||
+						pos.value.y + BULLET_SIZE < view.y - margin || pos.value.y > view.y + view.h + margin;
+					if (offscreen || bullet.age >= BULLET_LIFETIME) {
+						bullet.state = BulletState::inactive;
+					}
+					break;
+				}
+
+				case BulletState::colliding: {
+					if (sprite.animation.done) {
+						bullet.state = BulletState::inactive;
+					}
+					break;
+				}
+
+				case BulletState::inactive: {
+					break;
+				}
+			}
+
+			//returned to the pool at the next sync point
+			if (bullet.state == BulletState::inactive) {
+				scratch.commands.destroy(e);
+			}
+		});
+	});
+}
+
+// applies what the passes recorded, every worker's spawns, then their writes, then all of their destroys
+// sorted, and packs the surviving rows. Nothing iterates the world at this point, and with the destroys
+// sorted neither slot reuse nor compaction depends on which worker recorded what, so the outcome is the
+// same on any thread count
+void applyCommands(GameState& gameState) {
+
+	World& world = gameState.world;
+	for (WorkerScratch& scratch : gameState.scratch) {
+		scratch.commands.applySpawns(world);
+	}
+	for (WorkerScratch& scratch : gameState.scratch) {
+		scratch.commands.applyWrites(world);
+	}
+	std::vector<Entity>& destroys = gameState.destroys;
+	destroys.clear();
+	for (WorkerScratch& scratch : gameState.scratch) {
+		scratch.commands.takeDestroys(destroys);
+	}
+	std::sort(destroys.begin(), destroys.end());
+	destroys.erase(std::unique(destroys.begin(), destroys.end()), destroys.end());
+	for (Entity e : destroys) {
+		world.destroy(e);
+	}
+	world.compact();
+	gameState.bulletCount = static_cast<int>(gameState.world.count<BulletData>());
+}
+
+void followPlayer(GameState& gameState, float playerX) {
+	gameState.mapViewport.x = (playerX + TILE_SIZE / 2) - gameState.mapViewport.w / 2;
+}
+
+void levelCollisionResponse(Position& pos, Velocity& vel, const SDL_FRect& rectC) {
+
+	if (rectC.w < rectC.h) {
+		//horizonal collision
+		if (vel.value.x > 0) {
+			pos.value.x -= rectC.w;
+		}
+		else if (vel.value.x < 0) { //going left
+			pos.value.x += rectC.w;
+		}
+		vel.value.x = 0;
+	}
+	else {
+		//vertical collision
+		if (vel.value.y > 0) {
+			pos.value.y -= rectC.h;
+		}
+		else if (vel.value.y < 0) {
+			pos.value.y += rectC.h;
+		}
+		vel.value.y = 0;
+	}
+}
+
+void collisionResponse(const SDLState&, GameState& gameState, Resources &,
+	const SDL_FRect &, const SDL_FRect &, const SDL_FRect &rectC, Entity a, Entity b, float) {
+
+	World& world = gameState.world;
+	if (world.get<ObjectType>(a) == ObjectType::player) {
+
+		switch (world.get<ObjectType>(b)) {
+			case ObjectType::level: {
+				levelCollisionResponse(world.get<Position>(a), world.get<Velocity>(a), rectC);
+				break;
+			}
+
+			case ObjectType::player:
+			case ObjectType::enemy:
+			case ObjectType::bullet: {
+				break;
+			}
+		}
+	}
+}
+
+void checkCollissions(const SDLState& state, GameState& gameState, Resources &resources, 
+	Entity a, Entity b, float deltaTime) {
+
+	World& world = gameState.world;
+	SDL_FRect rectA = colliderRect(world.get<Position>(a), world.get<Collider>(a));
+	SDL_FRect rectB = colliderRect(world.get<Position>(b), world.get<Collider>(b));
+	SDL_FRect rectC{};
+
+	if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC)) {
+		collisionResponse(state, gameState, resources, rectA, rectB, rectC, a, b, deltaTime);
+	}
+}
+
+bool streamWorld(GameState& gameState) {
+
+	const SDL_FRect& view = gameState.mapViewport;
+	const TileGrid& grid = gameState.level;
+	const int c0 = static_cast<int>(std::floor((view.x - STREAM_MARGIN - grid.getOrigin().x) / grid.getTileSize()));
+	const int c1 = static_cast<int>(std::floor((view.x + view.w + STREAM_MARGIN - grid.getOrigin().x) / grid.getTileSize()));
+	const bool streaming = gameState.stream.update(c0, c1, [&](const levelfile::Spawn&) {
+		// the player is made when the level is opened and there are no enemies to spawn yet
+	});
+	if (!streaming) {
+		std::cerr << "Failed to stream level: " << gameState.stream.getError() << std::endl;
+	}
+	return streaming;
+}
+
+bool loadLevel(const SDLState& state, GameState& gameState, const Resources& resources, const std::string& path) {
+
+	// only the header and spawn points are read here, the tiles stream in around the viewport
+	WorldStream& stream = gameState.stream;
+	const int viewCols = static_cast<int>(std::ceil((gameState.mapViewport.w + 2 * STREAM_MARGIN) / TILE_SIZE));
+	std::string error;
+	if (!stream.open(path, static_cast<uint16_t>(resources.tileSprites.size()), CHUNK_COLS, viewCols, STREAM_PRELOAD_CHUNKS, error)) {
+		std::cerr << "Failed to load level " << path << ": " << error << std::endl;
+		return false;
+	}
+
+	// the bottom row of the level sits on the bottom of the screen
+	const int rows = static_cast<int>(stream.header().rows);
+	const int cols = static_cast<int>(stream.header().cols);
+	const glm::vec2 origin(0, state.logH - rows * TILE_SIZE);
+	gameState.background.resizeWindow(rows, cols, TILE_SIZE, origin, stream.windowCols());
+	gameState.level.resizeWindow(rows, cols, TILE_SIZE, origin, stream.windowCols());
+	gameState.foreground.resizeWindow(rows, cols, TILE_SIZE, origin, stream.windowCols());
+	stream.attach({ &gameState.background, &gameState.level, &gameState.foreground });
+
+	for (const levelfile::Spawn& spawn : stream.spawns()) {
+		const glm::vec2 position = origin + glm::vec2(spawn.col, spawn.row) * static_cast<float>(TILE_SIZE);
+		switch (spawn.type) {
+
+			case levelfile::SpawnType::player: {
+
+				// create our player
+				World& world = gameState.world;
+				Entity player = world.create();
+				world.add(player, ObjectType::player);
+				world.add(player, Position{ .value = position, .prev = position });
+				world.add(player, Velocity());
+				world.add(player, Body{
+					.type = BodyType::dynamic,
+					.maxSpeedX = 100,
+					.acceleration = glm::vec2(300, 0)
+				});
+				world.add(player, Collider{ .rect = { .x = 11, .y = 6, .w = 10, .h = 26 } });
+				world.add(player, Sprite{
+					.sheet = resources.sprIdle,
+					.animation = { .clip = resources.ANIM_PLAYER_IDLE },
+					.width = TILE_SIZE,
+					.height = TILE_SIZE
+				});
+				world.add(player, PlayerData());
+				gameState.player = player;
+				break;
+			}
+
+			case levelfile::SpawnType::enemy: {
+				// spawned as their chunk streams in
+				break;
+			}
+
+			case levelfile::SpawnType::count: {
+				// never read, the level file rejects spawn types it doesn't know
+				break;
+			}
+		}
+	}
+
+	if (gameState.player == NULL_ENTITY) {
+		std::cerr << "Level " << path << " has no player spawn" << std::endl;
+		return false;
+	}
+
+	// wait for the level around where the player starts
+	followPlayer(gameState, gameState.world.get<Position>(gameState.player).value.x);
+	return streamWorld(gameState);
+}
+
+void handleKeyInput(const SDLState &, GameState &gs, Entity e, SDL_Scancode key, bool keyDown) {
+	
+	const float JUMP_FORCE = -200.0f;
+
+	if (gs.world.has<PlayerData>(e)) {
+
+		PlayerData& player = gs.world.get<PlayerData>(e);
+		glm::vec2& velocity = gs.world.get<Velocity>(e).value;
+		switch (player.state) {
+
+			case PlayerState::idle: 
+				if (key == SDL_SCANCODE_K && keyDown) {
+					player.state = PlayerState::jumping;
+					velocity.y += JUMP_FORCE;
+				}
+				break;
+			
+
+			case PlayerState::running: 
+				if (key == SDL_SCANCODE_K && keyDown) {
+					player.state = PlayerState::jumping;
+					velocity.y += JUMP_FORCE;
+				}
+				break;
+			
+
+			case PlayerState::jumping:
+				break;
+		}
+	}
+}
+
+// to be called before simulating the tick, presses are handled as key presses
+void applyInput(const SDLState& state, GameState& gameState, TickInput input) {
+
+	gameState.input = input;
+	for (int b = 0; b < static_cast<int>(Button::count); b++) {
+		const Button button = static_cast<Button>(b);
+		if (input.wasPressed(button)) {
+			handleKeyInput(state, gameState, gameState.player, buttonKey(button), true);
+		}
+	}
+}
+
+// FNV-1a over where everything is, how it moves and what the player is doing. Two runs hashing the same
+// after a tick almost surely simulated it the same
+uint32_t hashState(GameState& gameState) {
+
+	uint32_t hash = 2166136261u;
+	const auto mix = [&hash](const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+	};
+
+	World& world = gameState.world;
+	for (auto [e, pos] : world.view<Position>()) {
+		mix(&pos.value, sizeof(pos.value));
+	}
+	for (auto [e, vel] : world.view<Velocity>()) {
+		mix(&vel.value, sizeof(vel.value));
+	}
+	for (auto [e, player] : world.view<PlayerData>()) {
+		mix(&player.state, sizeof(player.state));
+	}
+	mix(&gameState.bulletCount, sizeof(gameState.bulletCount));
+	return hash;
+}
+
+void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos, float scrollFactor,
+	float deltaTime) {
+	scrollPos -= xVelocity * scrollFactor * deltaTime;
+
+	if (scrollPos <= -texture->w) {
+		scrollPos = 0;
+	}
+
+	SDL_FRect dst{
+		.x = scrollPos, .y = 30,
+		.w = texture->w * 2.0f,
+		.h = static_cast<float>(texture->h)
+	};
+
+	SDL_RenderTextureTiled(renderer, texture, nullptr, 1, &dst);
+}
@@ -0,0 +1,312 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include "gameobject.h"
+#include "input.h"
+#include "spatialhash.h"
+#include "tilegrid.h"
+#include "jobsystem.h"
+#include "commandbuffer.h"
+#include "spritebatch.h"
+#include "tilechunks.h"
+#include "assetloader.h"
+#include "levelfile.h"
+#include "worldstream.h"
+#include "profiler.h"
+#include <vector>
+#include <glm/glm.hpp>
+#include <array>
+#include <cassert>
+#include <format>
+#include <iostream>
+#include <string>
+
+// The game's state and every step of a frame, shared by the executable and ShooterBench
+
+struct SDLState {
+	SDL_Window* window;
+	SDL_Renderer* renderer;
+	int width, height, logW, logH;
+	const bool* keys;
+
+	SDLState() : window(nullptr), renderer(nullptr), keys(SDL_GetKeyboardState(nullptr)) {
+
+	}
+};
+
+const int TILE_SIZE = 32;
+const int BULLET_SIZE = 4;
+const int MAX_BULLETS = 256;
+const float BULLET_LIFETIME = 2.0f;
+const size_t MAX_ENTITIES = MAX_BULLETS + 64;
+// entities per job when a pass is split across the job system
+const size_t JOB_GRAIN = 256;
+// tile columns baked into each chunk texture of a tile layer
+const int CHUNK_COLS = 16;
+// how far outside the viewport things are still drawn
+const float CULL_MARGIN = TILE_SIZE;
+// how far outside the viewport the level has to be in memory, covers drawing and bullets flying off screen
+const float STREAM_MARGIN = 2 * TILE_SIZE;
+// chunks of CHUNK_COLS columns kept loaded either side of the viewport
+const int STREAM_PRELOAD_CHUNKS = 2;
+
+struct Resources {
+	const int ANIM_PLAYER_IDLE = 0;
+	const int ANIM_PLAYER_RUN = 1;
+	const int ANIM_PLAYER_SLIDING = 2;
+	const int ANIM_BULLET_MOVING = 3;
+	const int ANIM_BULLET_HIT = 4;
+	// every animation there is, objects refer to them by index
+	std::vector<AnimationClip> clips;
+	// copied into every bullet fired
+	Sprite bulletSprite;
+
+	const uint16_t TILE_GROUND = 1;
+	const uint16_t TILE_PANEL = 2;
+	const uint16_t TILE_GRASS = 5;
+	const uint16_t TILE_BRICK = 6;
+	std::array<SpriteRef, 7> tileSprites{};
+
+	std::vector<SDL_Texture*> textures;
+	// sprite sheets and tiles share the atlas, the backgrounds are drawn tiled so they keep their own textures
+	TextureAtlas atlas;
+	SpriteRef sprIdle, sprRun, sprSlide, sprBullet, sprBulletHit;
+	SDL_Texture* texBg1{}, * texBg2{}, * texBg3{}, * texBg4{};
+
+	// makes a texture of a decoded surface on the render thread and frees the surface
+	SDL_Texture* upload(SDL_Renderer* renderer, SDL_Surface* surface) {
+
+		SDL_Texture* tex = surface ? SDL_CreateTextureFromSurface(renderer, surface) : nullptr;
+		SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST);
+		SDL_DestroySurface(surface);
+		textures.push_back(tex);
+		return tex;
+	}
+
+	void drawProgress(SDL_Renderer* renderer, int logW, int logH, float progress) {
+		const SDL_FRect outline{ .x = logW * 0.25f, .y = logH * 0.5f - 4, .w = logW * 0.5f, .h = 8 };
+		const SDL_FRect bar{ .x = outline.x + 2, .y = outline.y + 2, .w = (outline.w - 4) * progress, .h = outline.h - 4 };
+		SDL_SetRenderDrawColor(renderer, 20, 10, 30, 255);
+		SDL_RenderClear(renderer);
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+		SDL_RenderRect(renderer, &outline);
+		SDL_RenderFillRect(renderer, &bar);
+		SDL_RenderPresent(renderer);
+	}
+
+	void load(SDLState& state, JobSystem& jobs) {
+		clips.clear();
+		clips.emplace_back(8, 1.6f, TILE_SIZE, TILE_SIZE);		// ANIM_PLAYER_IDLE
+		clips.emplace_back(4, 0.5f, TILE_SIZE, TILE_SIZE);		// ANIM_PLAYER_RUN
+		clips.emplace_back(1, 1.0f, TILE_SIZE, TILE_SIZE);		// ANIM_PLAYER_SLIDING
+		clips.emplace_back(4, 0.05f, BULLET_SIZE, BULLET_SIZE);	// ANIM_BULLET_MOVING
+		clips.emplace_back(4, 0.15f, BULLET_SIZE, BULLET_SIZE);	// ANIM_BULLET_HIT
+		bulletSprite.animation.play(ANIM_BULLET_MOVING);
+		bulletSprite.width = BULLET_SIZE;
+		bulletSprite.height = BULLET_SIZE;
+
+		// running headless, there is nothing to upload textures to
+		if (!state.renderer) {
+			return;
+		}
+		PROFILE_SCOPE(load);
+
+		// decode every file on the workers, drawing the progress until they are done.
+		// The packed archive sits next to the executable, without it the loose files are used
+		const uint64_t startTime = SDL_GetTicksNS();
+		AssetArchive archive;
+		const char* basePath = SDL_GetBasePath();
+		archive.open(std::string(basePath ? basePath : "") + "assets.pak");
+		AssetLoader loader(jobs, &archive, "Shooter/data/");
+		const int idle = loader.add("idle.png");
+		const int run = loader.add("run.png");
+		const int slide = loader.add("slide.png");
+		const int brick = loader.add("tiles/brick.png");
+		const int grass = loader.add("tiles/grass.png");
+		const int ground = loader.add("tiles/ground.png");
+		const int panel = loader.add("tiles/panel.png");
+		const int bullet = loader.add("bullet.png");
+		const int bulletHit = loader.add("bullet_hit.png");
+		const int bg1 = loader.add("bg/bg_layer1.png");
+		const int bg2 = loader.add("bg/bg_layer2.png");
+		const int bg3 = loader.add("bg/bg_layer3.png");
+		const int bg4 = loader.add("bg/bg_layer4.png");
+		loader.start();
+		while (!loader.update()) {
+			SDL_PumpEvents();
+			drawProgress(state.renderer, state.logW, state.logH, loader.progress());
+		}
+		drawProgress(state.renderer, state.logW, state.logH, 1.0f);
+		const uint64_t decodedTime = SDL_GetTicksNS();
+
+		const uint64_t atlasStart = SDL_GetTicksNS();
+		{
+			PROFILE_SCOPE(atlas);
+			// the images go in the order they were added to the loader, so their loader ids are their atlas ids
+			for (int id = idle; id <= bulletHit; id++) {
+				[[maybe_unused]] const int atlasId = atlas.add(loader.take(id));
+				assert(atlasId == id);
+			}
+			atlas.pack();
+		}
+		const uint64_t atlasTime = SDL_GetTicksNS() - atlasStart;
+
+		std::vector<uint64_t> pageUploadTimes(atlas.pageCount());
+		for (size_t page = 0; page < pageUploadTimes.size(); page++) {
+			PROFILE_SCOPE(upload);
+			const uint64_t uploadStart = SDL_GetTicksNS();
+			atlas.upload(state.renderer, page);
+			pageUploadTimes[page] = SDL_GetTicksNS() - uploadStart;
+		}
+
+		sprIdle = atlas.get(idle);
+		sprRun = atlas.get(run);
+		sprSlide = atlas.get(slide);
+		sprBullet = atlas.get(bullet);
+		sprBulletHit = atlas.get(bulletHit);
+		tileSprites[TILE_GROUND] = atlas.get(ground);
+		tileSprites[TILE_PANEL] = atlas.get(panel);
+		tileSprites[TILE_GRASS] = atlas.get(grass);
+		tileSprites[TILE_BRICK] = atlas.get(brick);
+		bulletSprite.sheet = sprBullet;
+
+		std::array<uint64_t, 4> uploadTimes{};
+		SDL_Texture** backgrounds[] = { &texBg1, &texBg2, &texBg3, &texBg4 };
+		const int backgroundIds[] = { bg1, bg2, bg3, bg4 };
+		for (size_t i = 0; i < uploadTimes.size(); i++) {
+			PROFILE_SCOPE(upload);
+			const uint64_t uploadStart = SDL_GetTicksNS();
+			*backgrounds[i] = upload(state.renderer, loader.take(backgroundIds[i]));
+			uploadTimes[i] = SDL_GetTicksNS() - uploadStart;
+		}
+
+		const auto ms = [](uint64_t ns) { return ns / 1e6; };
+		for (size_t id = 0; id < loader.size(); id++) {
+			std::cout << std::format("{:<32} decode {:7.2f} ms", loader.name(static_cast<int>(id)),
+				ms(loader.decodeTime(static_cast<int>(id)))) << std::endl;
+		}
+		for (size_t i = 0; i < uploadTimes.size(); i++) {
+			std::cout << std::format("{:<32} upload {:7.2f} ms", loader.name(backgroundIds[i]), ms(uploadTimes[i])) << std::endl;
+		}
+		for (size_t page = 0; page < pageUploadTimes.size(); page++) {
+			std::cout << std::format("{:<32} upload {:7.2f} ms", std::format("atlas page {}", page), ms(pageUploadTimes[page])) << std::endl;
+		}
+		std::cout << std::format("atlas: {} pages packed in {:.2f} ms", atlas.pageCount(), ms(atlasTime)) << std::endl;
+		std::cout << std::format("assets: decoded from {} in {:.2f} ms on {} workers, ready in {:.2f} ms",
+			loader.fromArchive() ? "assets.pak" : "loose files", ms(decodedTime - startTime), jobs.workerCount(),
+			ms(SDL_GetTicksNS() - startTime)) << std::endl;
+	}
+
+	void unload() {
+		for (SDL_Texture* tex : textures) {
+			SDL_DestroyTexture(tex);
+		}
+		atlas.unload();
+	}
+};
+
+// fixed simulation rate, independent of the display refresh rate
+const uint64_t SIM_STEP_NS = SDL_NS_PER_SECOND / 60;
+const float SIM_DELTA_TIME = SIM_STEP_NS / static_cast<float>(SDL_NS_PER_SECOND);
+const int MAX_SIM_STEPS = 5;
+
+// where a bullet struck during this tick's move
+struct BulletHit {
+	Entity bullet;
+	Entity target;	// enemy that was hit, NULL_ENTITY for the level
+	float time;
+	glm::vec2 point;
+};
+
+// what a worker produces during a parallel pass, merged back once the pass is over
+struct alignas(64) WorkerScratch {
+	std::vector<Entity> candidates;
+	std::vector<BulletHit> bulletHits;
+	// spawns, destroys and component writes, applied at the next sync point
+	CommandBuffer<World> commands;
+	uint64_t pairTests = 0;
+	std::array<uint64_t, 3> bodyCounts{};
+};
+
+struct GameState {
+	// tile layers, the level layer is collided against by indexing cells directly.
+	// They only hold the columns around the viewport, streamed in from the level file
+	TileGrid background, level, foreground;
+	WorldStream stream;
+	// the tile layers baked for drawing
+	TileChunks backgroundChunks, levelChunks, foregroundChunks;
+	World world;
+	// live bullets plus the ones waiting to be spawned
+	int bulletCount;
+
+	JobSystem& jobs;
+	std::vector<WorkerScratch> scratch;
+	// every worker's destroys, merged when their commands are applied
+	std::vector<Entity> destroys;
+
+	// broadphase over the world's colliders, rebuilt every tick
+	SpatialHash<Entity> broadphase;
+	uint64_t pairTests;
+	// bodies processed by the simulation this frame, indexed by BodyType
+	std::array<uint64_t, 3> bodyCounts;
+
+	Entity player;
+	// what the player does in the tick being simulated, the simulation never reads the keyboard itself
+	TickInput input;
+	SDL_FRect mapViewport;
+	SpriteBatch sprites;
+	// objects and tile chunks drawn and skipped for being out of view this frame
+	int drawnCount, culledCount;
+	// the counters and frame profile, toggled with F3
+	bool showOverlay;
+	float bg2Scroll, bg3Scroll, bg4Scroll;
+
+	GameState(const SDLState &state, JobSystem &jobs) : jobs(jobs), scratch(jobs.workerCount()), broadphase(TILE_SIZE * 2) {
+		// sized up front so firing never grows the world or the command buffers
+		world.reserve(MAX_ENTITIES);
+		destroys.reserve(MAX_ENTITIES);
+		for (WorkerScratch& s : scratch) {
+			s.bulletHits.reserve(MAX_BULLETS);
+			s.commands.reserve(MAX_BULLETS);
+		}
+		bulletCount = 0;
+		pairTests = 0;
+		bodyCounts = {};
+		player = NULL_ENTITY;
+		mapViewport = SDL_FRect{
+			.x = 0,
+			.y = 0,
+			.w = static_cast<float>(state.logW),
+			.h = static_cast<float>(state.logH)
+		};
+		bg2Scroll = bg3Scroll = bg4Scroll = 0;
+		drawnCount = culledCount = 0;
+		showOverlay = false;
+	};
+
+	WorkerScratch& workerScratch() { return scratch[JobSystem::currentWorker()]; }
+};
+
+bool drawObject(const SDLState& state, GameState& gameState, const Resources& resources, const Position& pos, const Body& body,
+	const Sprite& sprite, float alpha);
+void drawTiles(const SDLState& state, GameState& gameState, const Resources& resources, TileChunks& chunks);
+void drawOverlay(const SDLState& state, GameState& gameState);
+void simulate(const SDLState& state, GameState& gameState, Resources& resources, float deltaTime);
+void updatePlayer(const SDLState& state, GameState& gameState, Resources& resources, Entity e, float deltaTime);
+void integrate(GameState& gameState, float deltaTime);
+void collide(const SDLState& state, GameState& gameState, Resources& resources, float deltaTime);
+void bulletHit(GameState& gameState, Resources& resources, Entity e);
+void sweepBullets(GameState& gameState, float deltaTime);
+void applyBulletHits(GameState& gameState, Resources& resources);
+void updateBullets(GameState& gameState, float deltaTime);
+void applyCommands(GameState& gameState);
+void followPlayer(GameState& gameState, float playerX);
+bool streamWorld(GameState& gameState);
+bool loadLevel(const SDLState& state, GameState& gameState, const Resources& resources, const std::string& path);
+void checkCollissions(const SDLState& state, GameState& gameState, Resources& resources,
+	Entity a, Entity b, float deltaTime);
+void levelCollisionResponse(Position& pos, Velocity& vel, const SDL_FRect& rectC);
+void handleKeyInput(const SDLState& state, GameState& gs, Entity e, SDL_Scancode key, bool keyDown);
+void applyInput(const SDLState& state, GameState& gameState, TickInput input);
+uint32_t hashState(GameState& gameState);
+void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos, float scrollFactor,
+	float deltaTime);
@@ -2,6 +2,9 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include "animation.h"
+#include "timer.h"
+#include "atlas.h"
+#include "ecs.h"
 #include <SDL3/SDL.h>
 
 enum class PlayerState {
@@ -22,49 +25,53 @@ struct PlayerData {
 	}
 };
 
-struct LevelData {};
-
 struct EnemyData {};
 
 struct BulletData {
 	BulletState state;
-	BulletData() : state(BulletState::moving) {
+	float age;
+	BulletData() : state(BulletState::moving), age(0) {
 
 	}
 };
 
-union ObjectData {
-	PlayerData player;
-	LevelData level;
-	EnemyData enemy;
-	BulletData bullet;
-};
-
 enum class ObjectType {
 	player, level, enemy, bullet
 };
 
-struct GameObject {
-	ObjectType type;
-	ObjectData data;
-	glm::vec2 position, velocity, acceleration;
-	float direction;
-	float maxSpeedX;
-	std::vector<Animation> animations;
-	int currentAnimation;
-	SDL_Texture* texture;
-	bool dynamic;
-	bool grounded;
-	SDL_FRect collider;
-
-	GameObject() : data{ .level = LevelData() }, collider{ 0 } {
-		type = ObjectType::level;
-		direction = 1;
-		maxSpeedX = 0;
-		position = velocity = acceleration = glm::vec2(0);
-		currentAnimation = -1;
-		texture = nullptr;
-		dynamic = false;
-		grounded = false;
-	}
-};
\ No newline at end of file
+// stationary bodies never move and are only collided against,
+// kinematic bodies move on their own velocity, dynamic bodies also get gravity
+enum class BodyType {
+	stationary, kinematic, dynamic
+};
+
+// components, the hot ones are kept small so the update passes stream through them
+
+struct Position {
+	glm::vec2 value = glm::vec2(0);
+	glm::vec2 prev = glm::vec2(0);
+};
+
+struct Velocity {
+	glm::vec2 value = glm::vec2(0);
+};
+
+struct Collider {
+	SDL_FRect rect{};
+};
+
+struct Body {
+	BodyType type = BodyType::stationary;
+	bool grounded = false;
+	float direction = 1;
+	float maxSpeedX = 0;
+	glm::vec2 acceleration = glm::vec2(0);
+};
+
+struct Sprite {
+	SpriteRef sheet;	// the frames of the clip are laid out left to right in here
+	AnimationPlayback animation;	// the clip is one of Resources::clips
+	float width = 0, height = 0;
+};
+
+using World = Registry<ObjectType, Position, Velocity, Body, Collider, Sprite, PlayerData, BulletData>;
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+
+// the buttons the simulation reads
+enum class Button : uint8_t {
+	left, right, fire, jump, count
+};
+
+// the key each button is on
+inline SDL_Scancode buttonKey(Button button) {
+	static const SDL_Scancode KEYS[] = { SDL_SCANCODE_A, SDL_SCANCODE_D, SDL_SCANCODE_J, SDL_SCANCODE_K };
+	return KEYS[static_cast<size_t>(button)];
+}
+
+// Everything the player did in one tick, a bit per button so recordings take a byte a tick. The low bits
+// are the buttons held while the tick ran, the high bits the ones pressed since the tick before it
+struct TickInput {
+	uint8_t bits = 0;
+
+	static uint8_t bit(Button button) { return static_cast<uint8_t>(1 << static_cast<int>(button)); }
+
+	// the pressed bit of the button on key, 0 for keys no button is on
+	static uint8_t pressBit(SDL_Scancode key) {
+		for (int b = 0; b < static_cast<int>(Button::count); b++) {
+			if (buttonKey(static_cast<Button>(b)) == key) {
+				return static_cast<uint8_t>(bit(static_cast<Button>(b)) << 4);
+			}
+		}
+		return 0;
+	}
+
+	// keys indexed by scancode like SDL_GetKeyboardState(), presses made of pressBit()s
+	static TickInput sample(const bool* keys, uint8_t presses) {
+		TickInput input{ .bits = presses };
+		for (int b = 0; b < static_cast<int>(Button::count); b++) {
+			if (keys[buttonKey(static_cast<Button>(b))]) {
+				input.bits |= bit(static_cast<Button>(b));
+			}
+		}
+		return input;
+	}
+
+	bool isHeld(Button button) const { return bits & bit(button); }
+	bool wasPressed(Button button) const { return bits & (bit(button) << 4); }
+};
+
+struct ScriptedKey {
+	int tick;
+	SDL_Scancode key;
+	bool down;
+};
+
+// Keyboard input played back from a script instead of the real keyboard.
+// Each script line is "<tick> <key> <down|up>", e.g. "120 k down". Lines starting with # are ignored.
+class ScriptedInput {
+	std::vector<ScriptedKey> events;
+	size_t next;
+
+public:
+	bool keys[SDL_SCANCODE_COUNT];
+
+	ScriptedInput() : next(0), keys{ false } {}
+
+	bool load(const std::string& filepath) {
+		std::ifstream file(filepath);
+		if (!file) {
+			return false;
+		}
+
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') {
+				continue;
+			}
+
+			std::istringstream in(line);
+			ScriptedKey event;
+			std::string key, action;
+			if (!(in >> event.tick >> key >> action) || key.size() != 1 || key[0] < 'a' || key[0] > 'z' ||
+				(action != "down" && action != "up")) {
+				return false;
+			}
+			event.key = static_cast<SDL_Scancode>(SDL_SCANCODE_A + (key[0] - 'a'));
+			event.down = action == "down";
+			events.push_back(event);
+		}
+
+		std::stable_sort(events.begin(), events.end(), [](const ScriptedKey& a, const ScriptedKey& b) {
+			return a.tick < b.tick;
+		});
+		return true;
+	}
+
+	// run right and left with pauses to shoot, jumping every couple of seconds
+	void loadDefault(int ticks) {
+		events.push_back({ 0, SDL_SCANCODE_J, true });
+		for (int tick = 0; tick < ticks; tick += 600) {
+			events.push_back({ tick, SDL_SCANCODE_D, true });
+			events.push_back({ tick + 240, SDL_SCANCODE_D, false });
+			events.push_back({ tick + 300, SDL_SCANCODE_A, true });
+			events.push_back({ tick + 540, SDL_SCANCODE_A, false });
+		}
+		for (int tick = 90; tick < ticks; tick += 150) {
+			events.push_back({ tick, SDL_SCANCODE_K, true });
+			events.push_back({ tick + 1, SDL_SCANCODE_K, false });
+		}
+
+		std::stable_sort(events.begin(), events.end(), [](const ScriptedKey& a, const ScriptedKey& b) {
+			return a.tick < b.tick;
+		});
+	}
+
+	// apply every event scheduled for this tick, calling onKey the way a key event would
+	template<typename Fn>
+	void play(int tick, Fn&& onKey) {
+		while (next < events.size() && events[next].tick <= tick) {
+			const ScriptedKey& event = events[next++];
+			keys[event.key] = event.down;
+			onKey(event.key, event.down);
+		}
+	}
+
+	// the input of tick, ticks have to be asked for in order
+	TickInput sample(int tick) {
+		uint8_t presses = 0;
+		play(tick, [&](SDL_Scancode key, bool down) {
+			if (down) {
+				presses |= TickInput::pressBit(key);
+			}
+		});
+		return TickInput::sample(keys, presses);
+	}
+};
@@ -0,0 +1,93 @@
+// jobbench.cpp : Scaling benchmark for the job system, runs the same parallelFor workload on 1 to N threads.
+//
+
+#include "jobsystem.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	size_t count = 1 << 20;
+	int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+	int repeats = 20;
+	size_t grain = 256;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--count" && i + 1 < argc) {
+			count = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			maxThreads = std::atoi(argv[++i]);
+		}
+		else if (arg == "--repeats" && i + 1 < argc) {
+			repeats = std::atoi(argv[++i]);
+		}
+		else if (arg == "--grain" && i + 1 < argc) {
+			grain = std::strtoull(argv[++i], nullptr, 10);
+		}
+	}
+	maxThreads = std::max(maxThreads, 1);
+	repeats = std::max(repeats, 1);
+
+	// a structure-of-arrays integration step like the simulation's, with some extra math per entity
+	std::vector<float> px(count, 0.0f), py(count, 0.0f), vx(count), vy(count);
+	for (size_t i = 0; i < count; i++) {
+		vx[i] = static_cast<float>(i % 100);
+		vy[i] = static_cast<float>(i % 37);
+	}
+
+	const auto step = [&](size_t begin, size_t end) {
+		const float dt = 1.0f / 60.0f;
+		for (size_t i = begin; i < end; i++) {
+			vy[i] += 500.0f * dt;
+			const float speed = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i]);
+			const float drag = 1.0f / (1.0f + 0.001f * speed);
+			vx[i] *= drag;
+			vy[i] *= drag;
+			px[i] += vx[i] * dt;
+			py[i] += vy[i] * dt;
+		}
+	};
+
+	std::cout << std::format("{} entities, grain {}, best of {} runs", count, grain, repeats) << std::endl;
+	std::cout << std::format("{:>8} {:>10} {:>10} {:>8}", "threads", "best ms", "avg ms", "speedup") << std::endl;
+
+	double baseline = 0;
+	for (int threads = 1; threads <= maxThreads; threads++) {
+		JobSystem jobs(threads);
+		jobs.parallelFor(count, grain, step); // warm up
+
+		double best = 1e30, total = 0;
+		for (int r = 0; r < repeats; r++) {
+			const auto start = std::chrono::steady_clock::now();
+			jobs.parallelFor(count, grain, step);
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ms);
+			total += ms;
+		}
+
+		if (threads == 1) {
+			baseline = best;
+		}
+		std::cout << std::format("{:>8} {:>10.3f} {:>10.3f} {:>7.2f}x", threads, best, total / repeats, baseline / best) << std::endl;
+	}
+
+	// every entity must have been stepped exactly once per run
+	const int runs = maxThreads * (repeats + 1);
+	float expected = 0, velocity = 0;
+	for (int r = 0; r < runs; r++) {
+		velocity += 500.0f / 60.0f;
+		velocity *= 1.0f / (1.0f + 0.001f * std::abs(velocity));
+		expected += velocity / 60.0f;
+	}
+	if (count && std::abs(py[0] - expected) > 1e-2f * std::max(1.0f, std::abs(expected))) {
+		std::cerr << std::format("Mismatch: entity 0 at {}, expected {}", py[0], expected) << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+
+// Small work-stealing job system. Every worker owns a deque: it takes its own jobs from the back and,
+// once that runs dry, steals from the front of the other workers' deques. The thread that creates the
+// system is worker 0 and runs jobs while it waits for them, so a system with one thread runs inline.
+class JobSystem {
+	struct Job {
+		void (*run)(void* context, size_t begin, size_t end);
+		void* context;
+		size_t begin, end;
+		std::atomic<size_t>* remaining;
+	};
+
+	struct alignas(64) Worker {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> queued;
+	std::atomic<bool> running;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	static inline thread_local int workerIndex = 0;
+
+	bool pop(int index, Job& job) {
+		Worker& worker = *workers[index];
+		std::lock_guard lock(worker.mutex);
+		if (worker.jobs.empty()) {
+			return false;
+		}
+		job = worker.jobs.back();
+		worker.jobs.pop_back();
+		queued--;
+		return true;
+	}
+
+	bool steal(int thief, Job& job) {
+		for (size_t i = 1; i < workers.size(); i++) {
+			Worker& victim = *workers[(thief + i) % workers.size()];
+			std::lock_guard lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				job = victim.jobs.front();
+				victim.jobs.pop_front();
+				queued--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool runOne(int index) {
+		Job job;
+		if (pop(index, job) || steal(index, job)) {
+			job.run(job.context, job.begin, job.end);
+			job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+			return true;
+		}
+		return false;
+	}
+
+	void workerLoop(int index) {
+		workerIndex = index;
+		while (running) {
+			if (!runOne(index)) {
+				std::unique_lock lock(sleepMutex);
+				wake.wait(lock, [this] { return queued > 0 || !running; });
+			}
+		}
+	}
+
+public:
+	JobSystem(int threadCount) : queued(0), running(true) {
+		threadCount = std::max(threadCount, 1);
+		for (int i = 0; i < threadCount; i++) {
+			workers.push_back(std::make_unique<Worker>());
+		}
+		for (int i = 1; i < threadCount; i++) {
+			threads.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+	}
+
+	~JobSystem() {
+		{
+			std::lock_guard lock(sleepMutex);
+			running = false;
+		}
+		wake.notify_all();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	int workerCount() const { return static_cast<int>(workers.size()); }
+
+	// index of the worker running the calling code, 0 for the thread that owns the system
+	static int currentWorker() { return workerIndex; }
+
+	// splits [0, count) into chunks of grain items and calls fn(begin, end) for each of them across the
+	// workers, returning once all of them are done
+	template<typename Fn>
+	void parallelFor(size_t count, size_t grain, Fn&& fn) {
+		if (count == 0) {
+			return;
+		}
+
+		grain = std::max<size_t>(grain, 1);
+		if (count <= grain || workers.size() == 1) {
+			fn(size_t(0), count);
+			return;
+		}
+
+		std::atomic<size_t> remaining;
+		dispatch(count, grain, fn, remaining);
+		wait(remaining);
+	}
+
+	// queues the same chunks as parallelFor but returns right away. remaining counts the chunks still to
+	// run, fn and remaining must stay alive until it reaches 0. With a single worker nothing runs until
+	// the caller helps with wait() or help()
+	template<typename Fn>
+	void dispatch(size_t count, size_t grain, Fn& fn, std::atomic<size_t>& remaining) {
+		grain = std::max<size_t>(grain, 1);
+		const size_t chunks = (count + grain - 1) / grain;
+		remaining.store(chunks, std::memory_order_release);
+		if (chunks == 0) {
+			return;
+		}
+
+		using F = std::remove_reference_t<Fn>;
+		const auto run = [](void* context, size_t begin, size_t end) {
+			(*static_cast<F*>(context))(begin, end);
+		};
+		void* context = const_cast<void*>(static_cast<const void*>(&fn));
+
+		const int self = workerIndex < workerCount() ? workerIndex : 0;
+		for (size_t i = 0; i < chunks; i++) {
+			Worker& worker = *workers[(self + i) % workers.size()];
+			std::lock_guard lock(worker.mutex);
+			worker.jobs.push_back(Job{ run, context, i * grain, std::min(count, (i + 1) * grain), &remaining });
+			queued++;
+		}
+		{
+			std::lock_guard lock(sleepMutex);
+		}
+		wake.notify_all();
+	}
+
+	// runs one queued job on the calling thread, false if there was none
+	bool help() {
+		return runOne(workerIndex < workerCount() ? workerIndex : 0);
+	}
+
+	// helps out until every chunk counted by remaining is done
+	void wait(const std::atomic<size_t>& remaining) {
+		while (remaining.load(std::memory_order_acquire) > 0) {
+			if (!help()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+};
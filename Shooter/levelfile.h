@@ -0,0 +1,167 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary level file, little endian:
+//   Header
+//   uint32_t kinds[layerCount]		which LayerKind each layer is, each kind at most once
+//   Spawn spawns[spawnCount]
+//   uint16_t tiles[layerCount][rows * cols]	row-major tile ids, 0 for empty
+// Nothing follows the last layer.
+namespace levelfile {
+	const uint32_t MAGIC = 0x564c4853; // "SHLV"
+	const uint32_t VERSION = 1;
+	// keeps rows * cols * layers well inside 32 bits
+	const uint32_t MAX_CELLS = 1u << 26;
+
+	enum class LayerKind : uint32_t {
+		background, level, foreground, count
+	};
+
+	enum class SpawnType : uint32_t {
+		player, enemy, count
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t rows, cols;
+		uint32_t layerCount;
+		uint32_t spawnCount;
+	};
+
+	struct Spawn {
+		SpawnType type;
+		uint32_t row, col;
+	};
+
+	// what a level file holds, the layers indexed by LayerKind and empty when the file has none of that kind
+	struct Level {
+		uint32_t rows = 0, cols = 0;
+		std::vector<uint16_t> layers[static_cast<size_t>(LayerKind::count)];
+		std::vector<Spawn> spawns;
+	};
+
+	// the part of a level file in front of the tiles, enough to find any cell in the file
+	struct Index {
+		Header header;
+		std::vector<LayerKind> kinds;
+		std::vector<Spawn> spawns;
+		size_t tilesOffset = 0;
+
+		// offset in the file of the cell (r, c) of the i-th layer stored
+		size_t cellOffset(size_t layer, uint32_t r, uint32_t c) const {
+			return tilesOffset + ((layer * header.rows + r) * header.cols + c) * sizeof(uint16_t);
+		}
+	};
+
+	template<typename T>
+	bool readAt(const uint8_t* bytes, size_t size, size_t& offset, T& value) {
+		if (size - offset < sizeof(T)) {
+			return false;
+		}
+		std::memcpy(&value, bytes + offset, sizeof(T));
+		offset += sizeof(T);
+		return true;
+	}
+
+	// how many bytes from the start of the file readIndex needs, 0 if header isn't a level file header
+	inline size_t indexSize(const Header& header) {
+		if (header.magic != MAGIC || header.layerCount > static_cast<uint32_t>(LayerKind::count)) {
+			return 0;
+		}
+		return sizeof(Header) + header.layerCount * sizeof(uint32_t) + static_cast<size_t>(header.spawnCount) * sizeof(Spawn);
+	}
+
+	// checks the header, layer kinds and spawn points in bytes against a file of fileSize bytes. The tiles
+	// aren't looked at, that is left to whoever reads them
+	inline bool readIndex(const uint8_t* bytes, size_t size, size_t fileSize, Index& index, std::string& error) {
+		size_t offset = 0;
+		Header& header = index.header;
+		if (!readAt(bytes, size, offset, header) || header.magic != MAGIC) {
+			error = "not a level file";
+			return false;
+		}
+		if (header.version != VERSION) {
+			error = "unsupported version " + std::to_string(header.version);
+			return false;
+		}
+		if (header.rows == 0 || header.cols == 0 || header.cols > MAX_CELLS / header.rows ||
+			header.layerCount > static_cast<uint32_t>(LayerKind::count)) {
+			error = "bad dimensions or layer count";
+			return false;
+		}
+		const size_t cells = static_cast<size_t>(header.rows) * header.cols;
+		const size_t expected = indexSize(header) + header.layerCount * cells * sizeof(uint16_t);
+		if (fileSize != expected || size < indexSize(header)) {
+			error = "size is " + std::to_string(fileSize) + " bytes, expected " + std::to_string(expected);
+			return false;
+		}
+
+		index.kinds.resize(header.layerCount);
+		for (size_t i = 0; i < index.kinds.size(); i++) {
+			LayerKind& kind = index.kinds[i];
+			readAt(bytes, size, offset, kind);
+			const auto earlier = index.kinds.begin() + i;
+			if (kind >= LayerKind::count || std::find(index.kinds.begin(), earlier, kind) != earlier) {
+				error = "bad or repeated layer kind";
+				return false;
+			}
+		}
+
+		index.spawns.resize(header.spawnCount);
+		for (Spawn& spawn : index.spawns) {
+			readAt(bytes, size, offset, spawn);
+			if (spawn.type >= SpawnType::count || spawn.row >= header.rows || spawn.col >= header.cols) {
+				error = "bad spawn point";
+				return false;
+			}
+		}
+		index.tilesOffset = offset;
+		return true;
+	}
+
+	// the highest id in tiles has to be below tileIdCount
+	inline bool checkTiles(const uint16_t* tiles, size_t count, uint16_t tileIdCount, std::string& error) {
+		uint16_t highest = 0;
+		for (size_t i = 0; i < count; i++) {
+			highest = tiles[i] > highest ? tiles[i] : highest;
+		}
+		if (highest >= tileIdCount) {
+			error = "tile id " + std::to_string(highest) + " out of range";
+			return false;
+		}
+		return true;
+	}
+
+	// the layers present in level are written in LayerKind order
+	inline bool save(const std::string& path, const Level& level) {
+		std::vector<uint32_t> kinds;
+		for (uint32_t kind = 0; kind < static_cast<uint32_t>(LayerKind::count); kind++) {
+			if (!level.layers[kind].empty()) {
+				kinds.push_back(kind);
+			}
+		}
+		const Header header{
+			.magic = MAGIC,
+			.version = VERSION,
+			.rows = level.rows,
+			.cols = level.cols,
+			.layerCount = static_cast<uint32_t>(kinds.size()),
+			.spawnCount = static_cast<uint32_t>(level.spawns.size())
+		};
+
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(kinds.data()), kinds.size() * sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(level.spawns.data()), level.spawns.size() * sizeof(Spawn));
+		for (uint32_t kind : kinds) {
+			file.write(reinterpret_cast<const char*>(level.layers[kind].data()), level.layers[kind].size() * sizeof(uint16_t));
+		}
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,78 @@
+// levelgen.cpp : Writes a generated level of any size, for benchmarking levels far bigger than the shipped ones.
+//
+// usage: LevelGen <level> [--rows N] [--cols N] [--seed N]
+
+#include "levelfile.h"
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::cerr << "usage: LevelGen <level> [--rows N] [--cols N] [--seed N]" << std::endl;
+		return 1;
+	}
+	const std::string path = argv[1];
+	uint32_t rows = 5, cols = 10000, seed = 1;
+	for (int i = 2; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--rows" && i + 1 < argc) {
+			rows = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--cols" && i + 1 < argc) {
+			cols = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--seed" && i + 1 < argc) {
+			seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+	if (rows < 3 || cols < 4 || cols > levelfile::MAX_CELLS / rows) {
+		std::cerr << "Level must be at least 3x4 and at most " << levelfile::MAX_CELLS << " cells" << std::endl;
+		return 1;
+	}
+
+	// the tile ids the game draws
+	const uint16_t GROUND = 1, PANEL = 2, GRASS = 5, BRICK = 6;
+
+	levelfile::Level level;
+	level.rows = rows;
+	level.cols = cols;
+	for (std::vector<uint16_t>& layer : level.layers) {
+		layer.assign(static_cast<size_t>(rows) * cols, 0);
+	}
+	std::vector<uint16_t>& background = level.layers[static_cast<size_t>(levelfile::LayerKind::background)];
+	std::vector<uint16_t>& tiles = level.layers[static_cast<size_t>(levelfile::LayerKind::level)];
+	std::vector<uint16_t>& foreground = level.layers[static_cast<size_t>(levelfile::LayerKind::foreground)];
+	const auto at = [cols](uint32_t r, uint32_t c) { return static_cast<size_t>(r) * cols + c; };
+
+	// ground along the bottom with the odd gap, panels stacked into platforms above it
+	std::mt19937 random(seed);
+	const uint32_t ground = rows - 1;
+	for (uint32_t c = 0; c < cols; c++) {
+		const bool gap = c > 8 && random() % 16 == 0;
+		if (!gap) {
+			tiles[at(ground, c)] = GROUND;
+			if (random() % 3 == 0) {
+				foreground[at(ground - 1, c)] = GRASS;
+			}
+		}
+		if (c > 8 && random() % 6 == 0) {
+			const uint32_t height = 1 + random() % (rows - 2);
+			tiles[at(ground - height, c)] = PANEL;
+		}
+		if (random() % 10 == 0) {
+			background[at(random() % ground, c)] = BRICK;
+		}
+	}
+
+	level.spawns.push_back(levelfile::Spawn{ .type = levelfile::SpawnType::player, .row = ground - 1, .col = 2 });
+	if (!levelfile::save(path, level)) {
+		std::cerr << "Failed to write " << path << std::endl;
+		return 1;
+	}
+	std::cout << std::format("{}x{} level written to {}", cols, rows, path) << std::endl;
+	return 0;
+}
@@ -0,0 +1,240 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <string>
+#include "trace.h"
+
+// 0 compiles the PROFILE_ macros down to nothing, set by the SHOOTER_PROFILING CMake option
+#ifndef SHOOTER_PROFILING
+#define SHOOTER_PROFILING 1
+#endif
+
+// Scoped timers for the phases of a frame. Each thread writes its samples to a ring of its own without
+// taking a lock, the render thread drains every ring once a frame into per-phase totals that are kept for
+// the last HISTORY frames. A ring that fills up before it is drained drops samples and counts them.
+// While a trace is being captured the drained samples also go to a TraceWriter.
+namespace profiler {
+	enum class Phase : uint8_t {
+		events, stream, simulate, bullets, collide, integrate, background, tiles, objects, overlay, present, chunkRead,
+		load, decode, atlas, upload, count
+	};
+
+	struct PhaseInfo {
+		const char* name;
+		int depth;	// how many other phases it is timed inside of
+	};
+
+	inline const PhaseInfo& phaseInfo(Phase phase) {
+		static const PhaseInfo INFO[] = {
+			{ "events", 0 }, { "stream", 0 }, { "simulate", 0 }, { "bullets", 1 }, { "collide", 1 }, { "integrate", 1 },
+			{ "background", 0 }, { "tiles", 0 }, { "objects", 0 }, { "overlay", 0 }, { "present", 0 }, { "chunk read", 0 },
+			{ "load", 0 }, { "decode", 1 }, { "atlas", 1 }, { "upload", 1 }
+		};
+		return INFO[static_cast<size_t>(phase)];
+	}
+
+	struct Sample {
+		Phase phase;
+		uint64_t start, end;
+	};
+
+	// written by the thread that owns it, read by the one draining it
+	class Ring {
+		static const size_t CAPACITY = 1024;
+		std::array<Sample, CAPACITY> samples;
+		alignas(64) std::atomic<uint64_t> head;		// next to write
+		alignas(64) std::atomic<uint64_t> tail;		// next to read
+		std::atomic<uint64_t> dropped;
+
+	public:
+		// for traces, index is the order the thread first recorded in
+		uint32_t index;
+		std::string name;
+
+		Ring(uint32_t index) : head(0), tail(0), dropped(0), index(index), name(std::format("thread {}", index)) {}
+
+		void push(const Sample& sample) {
+			const uint64_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) == CAPACITY) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			samples[h % CAPACITY] = sample;
+			head.store(h + 1, std::memory_order_release);
+		}
+
+		template<typename Fn>
+		void drain(Fn&& fn) {
+			uint64_t t = tail.load(std::memory_order_relaxed);
+			const uint64_t h = head.load(std::memory_order_acquire);
+			for (; t < h; t++) {
+				fn(samples[t % CAPACITY]);
+			}
+			tail.store(t, std::memory_order_release);
+		}
+
+		uint64_t takeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+	};
+
+	const size_t HISTORY = 240;
+	const size_t PHASES = static_cast<size_t>(Phase::count);
+
+	struct PhaseStats {
+		uint64_t current, average, worst;
+	};
+
+	class Profiler {
+		// only taken by a thread recording its first sample and by endFrame()
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Ring>> rings;
+		// time spent in every phase and the frame time, for each of the last HISTORY frames
+		std::array<std::array<uint64_t, HISTORY>, PHASES> phaseTimes{};
+		std::array<uint64_t, HISTORY> frameTimes{};
+		size_t frame = 0;
+		uint64_t dropped = 0;
+		TraceWriter trace;
+		int traceFrames = 0;
+
+		static inline thread_local Ring* ring = nullptr;
+
+		Profiler() = default;
+
+		// a capture cut short by the program ending still makes a complete file
+		~Profiler() {
+			if (trace.isCapturing()) {
+				trace.close(threadNames());
+			}
+		}
+
+		std::vector<std::string> threadNames() const {
+			std::vector<std::string> names;
+			for (const std::unique_ptr<Ring>& r : rings) {
+				names.push_back(r->name);
+			}
+			return names;
+		}
+
+		Ring& threadRing() {
+			if (!ring) {
+				std::lock_guard lock(mutex);
+				rings.push_back(std::make_unique<Ring>(static_cast<uint32_t>(rings.size())));
+				ring = rings.back().get();
+			}
+			return *ring;
+		}
+
+	public:
+		static Profiler& get() {
+			static Profiler profiler;
+			return profiler;
+		}
+
+		void record(Phase phase, uint64_t start, uint64_t end) {
+			threadRing().push(Sample{ .phase = phase, .start = start, .end = end });
+		}
+
+		// what traces call the calling thread
+		void nameThread(const char* name) {
+			Ring& r = threadRing();
+			std::lock_guard lock(mutex);
+			r.name = name;
+		}
+
+		// captures the next frames frames into a Chrome trace at path, false while another capture is running
+		bool startTrace(const std::string& path, int frames) {
+			if (trace.isCapturing() || frames <= 0) {
+				return false;
+			}
+			trace.open(path);
+			traceFrames = frames;
+			return true;
+		}
+
+		bool isTracing() const { return trace.isCapturing(); }
+
+		// once a frame on the render thread, everything recorded since the last call counts for this frame
+		void endFrame(uint64_t frameNs) {
+			const size_t slot = frame % HISTORY;
+			for (std::array<uint64_t, HISTORY>& times : phaseTimes) {
+				times[slot] = 0;
+			}
+			frameTimes[slot] = frameNs;
+
+			std::lock_guard lock(mutex);
+			const bool tracing = trace.isCapturing();
+			for (std::unique_ptr<Ring>& r : rings) {
+				r->drain([&](const Sample& sample) {
+					phaseTimes[static_cast<size_t>(sample.phase)][slot] += sample.end - sample.start;
+					if (tracing) {
+						trace.add(TraceWriter::Event{ .name = phaseInfo(sample.phase).name, .thread = r->index, .start = sample.start,
+							.end = sample.end });
+					}
+				});
+				dropped += r->takeDropped();
+			}
+			frame++;
+
+			if (tracing && --traceFrames == 0) {
+				trace.close(threadNames());
+			}
+		}
+
+		// frames the history holds
+		size_t frames() const { return std::min(frame, HISTORY); }
+		// samples lost to a full ring since the start, the phases they belong to read low by that much
+		uint64_t droppedSamples() const { return dropped; }
+
+		// over the frames in the history, current being the last one
+		PhaseStats stats(Phase phase) const {
+			PhaseStats result{};
+			const std::array<uint64_t, HISTORY>& times = phaseTimes[static_cast<size_t>(phase)];
+			const size_t count = frames();
+			if (count == 0) {
+				return result;
+			}
+			uint64_t total = 0;
+			for (size_t i = 0; i < count; i++) {
+				total += times[i];
+				result.worst = std::max(result.worst, times[i]);
+			}
+			result.current = times[(frame - 1) % HISTORY];
+			result.average = total / count;
+			return result;
+		}
+
+		// age 0 is the last frame
+		uint64_t frameTime(size_t age) const { return frameTimes[(frame - 1 - age) % HISTORY]; }
+	};
+
+	class Scope {
+		Phase phase;
+		uint64_t start;
+
+	public:
+		explicit Scope(Phase phase) : phase(phase), start(SDL_GetTicksNS()) {}
+		~Scope() { Profiler::get().record(phase, start, SDL_GetTicksNS()); }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+}
+
+#if SHOOTER_PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// times the rest of the enclosing block as profiler::Phase::phase
+#define PROFILE_SCOPE(phase) profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(profiler::Phase::phase)
+#define PROFILE_END_FRAME(frameNs) profiler::Profiler::get().endFrame(frameNs)
+#define PROFILE_THREAD(name) profiler::Profiler::get().nameThread(name)
+#else
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_END_FRAME(frameNs) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,185 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "input.h"
+
+// A recording of the input of every tick of a session, which played back from the same level simulates
+// the same game again. Next to each tick's input is a hash of the state the tick ended in, playing back
+// checks against it to find the first tick that went differently.
+//
+// File layout, little endian:
+//   Header
+//   level path, Header::levelPathLength bytes
+//   for every tick: input byte, uint32 state hash
+namespace replay {
+	const uint32_t MAGIC = 0x50524853;	// "SHRP"
+	const uint32_t VERSION = 1;
+	const size_t TICK_SIZE = 1 + sizeof(uint32_t);
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t levelPathLength;
+	};
+
+	struct Replay {
+		std::string levelPath;
+		std::vector<TickInput> inputs;
+		std::vector<uint32_t> hashes;
+
+		size_t ticks() const { return inputs.size(); }
+	};
+
+	// a recording cut short by a crash still loads, up to its last whole tick
+	inline bool load(const std::string& path, Replay& replay, std::string& error) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			error = "can't open file";
+			return false;
+		}
+		const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		Header header;
+		if (bytes.size() < sizeof(header)) {
+			error = "file is too small";
+			return false;
+		}
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		if (header.magic != MAGIC) {
+			error = "not a replay file";
+			return false;
+		}
+		if (header.version != VERSION) {
+			error = "unsupported version " + std::to_string(header.version);
+			return false;
+		}
+		if (header.levelPathLength > bytes.size() - sizeof(header)) {
+			error = "level path runs past the end of the file";
+			return false;
+		}
+
+		size_t offset = sizeof(header);
+		replay.levelPath.assign(reinterpret_cast<const char*>(bytes.data() + offset), header.levelPathLength);
+		offset += header.levelPathLength;
+		const size_t ticks = (bytes.size() - offset) / TICK_SIZE;
+		replay.inputs.resize(ticks);
+		replay.hashes.resize(ticks);
+		for (size_t i = 0; i < ticks; i++, offset += TICK_SIZE) {
+			replay.inputs[i].bits = bytes[offset];
+			std::memcpy(&replay.hashes[i], bytes.data() + offset + 1, sizeof(uint32_t));
+		}
+		return true;
+	}
+}
+
+// Records ticks into a replay file. The ticks are encoded on the thread adding them and handed in blocks
+// to a thread of its own that writes them, so recording never waits on the disk. Unlike a trace nothing
+// is dropped when the writer falls behind, a replay missing ticks would be useless.
+class ReplayWriter {
+	static const size_t BLOCK_TICKS = 4096;
+
+	std::vector<uint8_t> block;
+	uint64_t ticks;
+
+	std::ofstream file;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<std::vector<uint8_t>> queue;
+	bool stopping;
+	bool failed;
+
+	void flushBlock() {
+		if (block.empty()) {
+			return;
+		}
+		{
+			std::lock_guard lock(mutex);
+			queue.push_back(std::move(block));
+		}
+		wake.notify_one();
+		block = {};
+		block.reserve(BLOCK_TICKS * replay::TICK_SIZE);
+	}
+
+	void run() {
+		std::unique_lock lock(mutex);
+		while (true) {
+			wake.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;
+			}
+			std::vector<uint8_t> bytes = std::move(queue.front());
+			queue.erase(queue.begin());
+			lock.unlock();
+
+			file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			const bool ok = static_cast<bool>(file);
+
+			lock.lock();
+			failed = failed || !ok;
+		}
+	}
+
+public:
+	ReplayWriter() : ticks(0), stopping(false), failed(false) {}
+
+	~ReplayWriter() { close(); }
+
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+	bool isRecording() const { return thread.joinable(); }
+	uint64_t getTicks() const { return ticks; }
+
+	// the header is written before returning, so a path that can't be written to fails here
+	bool open(const std::string& path, const std::string& levelPath) {
+		file.open(path, std::ios::binary | std::ios::trunc);
+		const replay::Header header{ .magic = replay::MAGIC, .version = replay::VERSION,
+			.levelPathLength = static_cast<uint32_t>(levelPath.size()) };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(levelPath.data(), static_cast<std::streamsize>(levelPath.size()));
+		if (!file) {
+			file.close();
+			return false;
+		}
+		ticks = 0;
+		stopping = failed = false;
+		block.reserve(BLOCK_TICKS * replay::TICK_SIZE);
+		thread = std::thread(&ReplayWriter::run, this);
+		return true;
+	}
+
+	void add(TickInput input, uint32_t hash) {
+		uint8_t bytes[replay::TICK_SIZE];
+		bytes[0] = input.bits;
+		std::memcpy(bytes + 1, &hash, sizeof(hash));
+		block.insert(block.end(), bytes, bytes + replay::TICK_SIZE);
+		ticks++;
+		if (block.size() == BLOCK_TICKS * replay::TICK_SIZE) {
+			flushBlock();
+		}
+	}
+
+	// writes what is left and waits for the writer, false if any of the file failed to write
+	bool close() {
+		if (!thread.joinable()) {
+			return !failed;
+		}
+		flushBlock();
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		thread.join();
+		file.close();
+		return !failed && static_cast<bool>(file);
+	}
+};
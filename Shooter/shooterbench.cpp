@@ -0,0 +1,349 @@
+// shooterbench.cpp : Microbenchmarks for the hot paths of the game. Runs headless, drawing goes to a software
+// renderer, so it gives the same numbers on a build machine without a display.
+//
+// usage: ShooterBench [--repeats N] [--threads N] [--filter TEXT] [--json PATH]
+
+#include "game.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct Benchmark {
+	std::string name;
+	size_t ops;		// operations per run, times are reported per operation
+	// sets the benchmark up and returns what does one run of it, which owns everything set up.
+	// Returns nothing when the benchmark can't run here
+	std::function<std::function<void()>()> setup;
+};
+
+struct BenchStats {
+	double min, median, mean, stddev, p95, max;
+};
+
+BenchStats summarize(std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	const size_t n = samples.size();
+	BenchStats stats{};
+	stats.min = samples.front();
+	stats.max = samples.back();
+	stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+	stats.p95 = samples[std::min(static_cast<size_t>(std::ceil(n * 0.95)), n) - 1];
+	stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+	double variance = 0;
+	for (double sample : samples) {
+		variance += (sample - stats.mean) * (sample - stats.mean);
+	}
+	stats.stddev = n > 1 ? std::sqrt(variance / (n - 1)) : 0;
+	return stats;
+}
+
+// results nothing reads are written here, so the compiler can't drop the work producing them
+volatile float sink;
+
+// a flat level of ground tiles, every column of it resident, with the player standing at the left end
+void makeLevel(const SDLState& state, GameState& gameState, const Resources& resources, int cols) {
+	const int rows = 5;
+	const glm::vec2 origin(0, state.logH - rows * TILE_SIZE);
+	gameState.background.resize(rows, cols, TILE_SIZE, origin);
+	gameState.level.resize(rows, cols, TILE_SIZE, origin);
+	gameState.foreground.resize(rows, cols, TILE_SIZE, origin);
+	for (int c = 0; c < cols; c++) {
+		gameState.level.set(rows - 1, c, resources.TILE_GROUND);
+	}
+
+	World& world = gameState.world;
+	const glm::vec2 position = origin + glm::vec2(2, rows - 2) * static_cast<float>(TILE_SIZE);
+	Entity player = world.create();
+	world.add(player, ObjectType::player);
+	world.add(player, Position{ .value = position, .prev = position });
+	world.add(player, Velocity());
+	world.add(player, Body{ .type = BodyType::dynamic, .maxSpeedX = 100, .acceleration = glm::vec2(300, 0) });
+	world.add(player, Collider{ .rect = { .x = 11, .y = 6, .w = 10, .h = 26 } });
+	world.add(player, Sprite{ .sheet = {}, .animation = { .clip = resources.ANIM_PLAYER_IDLE }, .width = TILE_SIZE, .height = TILE_SIZE });
+	world.add(player, PlayerData());
+	gameState.player = player;
+}
+
+// enemies standing on the ground one to a column from column first on, they don't move so every run
+// simulates the same scene
+void addEnemies(GameState& gameState, const Resources& resources, int count, int first) {
+	World& world = gameState.world;
+	const glm::vec2 origin = gameState.level.getOrigin();
+	for (int i = 0; i < count; i++) {
+		const glm::vec2 position = origin + glm::vec2(first + i, gameState.level.getRows() - 2) * static_cast<float>(TILE_SIZE);
+		Entity enemy = world.create();
+		world.add(enemy, ObjectType::enemy);
+		world.add(enemy, Position{ .value = position, .prev = position });
+		world.add(enemy, Velocity());
+		world.add(enemy, Body{ .type = BodyType::kinematic, .direction = i % 2 ? -1.0f : 1.0f });
+		world.add(enemy, Collider{ .rect = { .x = 11, .y = 6, .w = 10, .h = 26 } });
+		world.add(enemy, Sprite{ .sheet = {}, .animation = { .clip = resources.ANIM_PLAYER_RUN, .time = i * 0.01f }, .width = TILE_SIZE,
+			.height = TILE_SIZE });
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int repeats = 10;
+	int threads = static_cast<int>(std::thread::hardware_concurrency());
+	std::string filter;
+	std::string jsonPath;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--repeats" && i + 1 < argc) {
+			repeats = std::atoi(argv[++i]);
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			threads = std::atoi(argv[++i]);
+		}
+		else if (arg == "--filter" && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (arg == "--json" && i + 1 < argc) {
+			jsonPath = argv[++i];
+		}
+	}
+	repeats = std::max(repeats, 1);
+
+	SDLState state;
+	state.logW = 640;
+	state.logH = 320;
+	static const bool noKeys[SDL_SCANCODE_COUNT]{};
+	state.keys = noKeys;
+
+	if (!SDL_Init(0)) {
+		std::cerr << "Failed to initialize SDL" << std::endl;
+		return 1;
+	}
+
+	// headless, only the animation clips are made
+	JobSystem jobs(threads);
+	Resources resources;
+	resources.load(state, jobs);
+
+	std::vector<Benchmark> benchmarks;
+
+	for (const bool overlapping : { true, false }) {
+		benchmarks.push_back(Benchmark{
+			.name = overlapping ? "checkCollissions/overlapping" : "checkCollissions/apart",
+			.ops = 1000000,
+			.setup = [&, overlapping]() -> std::function<void()> {
+				auto gameState = std::make_shared<GameState>(state, jobs);
+				makeLevel(state, *gameState, resources, 64);
+				World& world = gameState->world;
+				const glm::vec2 start = world.get<Position>(gameState->player).value;
+				Entity box = world.create();
+				world.add(box, ObjectType::level);
+				const glm::vec2 boxPos = start + glm::vec2(overlapping ? 16 : 64, 0);
+				world.add(box, Position{ .value = boxPos, .prev = boxPos });
+				world.add(box, Collider{ .rect = { .x = 0, .y = 0, .w = TILE_SIZE, .h = TILE_SIZE } });
+				return [&, gameState, box, start] {
+					World& world = gameState->world;
+					Position& pos = world.get<Position>(gameState->player);
+					Velocity& vel = world.get<Velocity>(gameState->player);
+					for (int i = 0; i < 1000000; i++) {
+						// the response pushes the player out, put it back for the next one
+						pos.value = start;
+						vel.value = glm::vec2(50, 0);
+						checkCollissions(state, *gameState, resources, gameState->player, box, SIM_DELTA_TIME);
+					}
+					sink = pos.value.x;
+				};
+			}
+		});
+	}
+
+	// simulation ticks, the player and count enemies on a level as wide as they need
+	for (const auto& [count, ticks, label] : { std::tuple(10, 2000, "10"), std::tuple(1000, 200, "1k"), std::tuple(100000, 2, "100k") }) {
+		benchmarks.push_back(Benchmark{
+			.name = std::format("simulate/{} objects", label),
+			.ops = static_cast<size_t>(ticks),
+			.setup = [&, count, ticks]() -> std::function<void()> {
+				auto gameState = std::make_shared<GameState>(state, jobs);
+				makeLevel(state, *gameState, resources, count + 8);
+				addEnemies(*gameState, resources, count, 6);
+				return [&, gameState, ticks] {
+					for (int tick = 0; tick < ticks; tick++) {
+						gameState->pairTests = 0;
+						gameState->bodyCounts = {};
+						simulate(state, *gameState, resources, SIM_DELTA_TIME);
+						// drained every tick as the game does, so the profiler's rings never fill up
+						PROFILE_END_FRAME(0);
+					}
+				};
+			}
+		});
+	}
+
+	benchmarks.push_back(Benchmark{
+		.name = "AnimationPlayback::step",
+		.ops = 1000000,
+		.setup = [&]() -> std::function<void()> {
+			return [&] {
+				AnimationPlayback playback;
+				playback.play(resources.ANIM_PLAYER_RUN);
+				const AnimationClip& clip = resources.clips[resources.ANIM_PLAYER_RUN];
+				for (int i = 0; i < 1000000; i++) {
+					playback.step(clip, SIM_DELTA_TIME);
+				}
+				sink = playback.time;
+			};
+		}
+	});
+
+	benchmarks.push_back(Benchmark{
+		.name = "AnimationClip::frameRect",
+		.ops = 1000000,
+		.setup = [&]() -> std::function<void()> {
+			return [&] {
+				const AnimationClip& clip = resources.clips[resources.ANIM_PLAYER_IDLE];
+				float x = 0;
+				for (int i = 0; i < 1000000; i++) {
+					x += clip.frameRect(std::fmod(i * SIM_DELTA_TIME, clip.getLength())).x;
+				}
+				sink = x;
+			};
+		}
+	});
+
+	// opening a level through to its first chunks being in the grids
+	const std::filesystem::path levelPath = std::filesystem::temp_directory_path() / "shooterbench.lvl";
+	benchmarks.push_back(Benchmark{
+		.name = "loadLevel/10k columns",
+		.ops = 20,
+		.setup = [&]() -> std::function<void()> {
+			levelfile::Level level;
+			level.rows = 5;
+			level.cols = 10000;
+			for (std::vector<uint16_t>& layer : level.layers) {
+				layer.assign(static_cast<size_t>(level.rows) * level.cols, 0);
+			}
+			std::vector<uint16_t>& tiles = level.layers[static_cast<size_t>(levelfile::LayerKind::level)];
+			std::fill(tiles.end() - level.cols, tiles.end(), resources.TILE_GROUND);
+			level.spawns.push_back(levelfile::Spawn{ .type = levelfile::SpawnType::player, .row = level.rows - 2, .col = 2 });
+			if (!levelfile::save(levelPath.string(), level)) {
+				std::cerr << "Failed to write " << levelPath.string() << std::endl;
+				return {};
+			}
+			return [&] {
+				for (int i = 0; i < 20; i++) {
+					GameState gameState(state, jobs);
+					if (!loadLevel(state, gameState, resources, levelPath.string())) {
+						std::exit(1);
+					}
+				}
+			};
+		}
+	});
+
+	// a frame of sprites across the screen drawn into a surface, per sprite including its share of the flush
+	benchmarks.push_back(Benchmark{
+		.name = "drawObject/1k sprites",
+		.ops = 100 * 1000,
+		.setup = [&]() -> std::function<void()> {
+			SDL_Surface* surface = SDL_CreateSurface(state.logW, state.logH, SDL_PIXELFORMAT_RGBA32);
+			SDL_Renderer* renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+			SDL_Texture* sheet = renderer ? SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, 8 * TILE_SIZE,
+				TILE_SIZE) : nullptr;
+			if (!sheet) {
+				std::cerr << "Failed to make a software renderer: " << SDL_GetError() << std::endl;
+				SDL_DestroyRenderer(renderer);
+				SDL_DestroySurface(surface);
+				return {};
+			}
+			std::shared_ptr<SDL_Renderer> owner(renderer, [surface, sheet](SDL_Renderer* renderer) {
+				SDL_DestroyTexture(sheet);
+				SDL_DestroyRenderer(renderer);
+				SDL_DestroySurface(surface);
+			});
+
+			auto gameState = std::make_shared<GameState>(state, jobs);
+			World& world = gameState->world;
+			for (int i = 0; i < 1000; i++) {
+				const glm::vec2 position((i * 37) % (state.logW - TILE_SIZE), (i * 13) % (state.logH - TILE_SIZE));
+				Entity e = world.create();
+				world.add(e, Position{ .value = position, .prev = position });
+				world.add(e, Body{ .direction = i % 2 ? -1.0f : 1.0f });
+				world.add(e, Sprite{ .sheet = { .atlas = sheet, .rect = { .x = 0, .y = 0, .w = 8 * TILE_SIZE, .h = TILE_SIZE } },
+					.animation = { .clip = resources.ANIM_PLAYER_IDLE, .time = i * 0.01f }, .width = TILE_SIZE, .height = TILE_SIZE });
+			}
+			return [&, gameState, owner] {
+				for (int frame = 0; frame < 100; frame++) {
+					for (auto [e, pos, body, sprite] : gameState->world.view<Position, Body, Sprite>()) {
+						drawObject(state, *gameState, resources, pos, body, sprite, 0.5f);
+					}
+					gameState->sprites.flush(owner.get());
+				}
+			};
+		}
+	});
+
+	struct Result {
+		const Benchmark* benchmark;
+		std::vector<double> samples;	// ns per operation, one for each run
+		BenchStats stats;
+	};
+	std::vector<Result> results;
+
+	std::cout << std::format("{} threads, {} runs of each after a warm-up, ns per operation", jobs.workerCount(), repeats) << std::endl;
+	std::cout << std::format("{:<30}{:>10}{:>12}{:>12}{:>12}{:>12}{:>12}", "benchmark", "ops", "min", "median", "mean", "stddev",
+		"p95") << std::endl;
+	for (const Benchmark& benchmark : benchmarks) {
+		if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+			continue;
+		}
+		std::function<void()> run = benchmark.setup();
+		if (!run) {
+			std::cout << std::format("{:<30}{:>10}", benchmark.name, "skipped") << std::endl;
+			continue;
+		}
+		run();
+
+		Result result{ .benchmark = &benchmark, .samples = {}, .stats = {} };
+		for (int i = 0; i < repeats; i++) {
+			const uint64_t start = SDL_GetTicksNS();
+			run();
+			result.samples.push_back(static_cast<double>(SDL_GetTicksNS() - start) / benchmark.ops);
+		}
+		result.stats = summarize(result.samples);
+		const BenchStats& s = result.stats;
+		std::cout << std::format("{:<30}{:>10}{:>12.1f}{:>12.1f}{:>12.1f}{:>12.1f}{:>12.1f}", benchmark.name, benchmark.ops, s.min, s.median,
+			s.mean, s.stddev, s.p95) << std::endl;
+		results.push_back(std::move(result));
+	}
+	std::filesystem::remove(levelPath);
+
+	if (!jsonPath.empty()) {
+		std::ofstream file(jsonPath, std::ios::trunc);
+		if (!file) {
+			std::cerr << "Failed to write " << jsonPath << std::endl;
+			SDL_Quit();
+			return 1;
+		}
+		file << std::format("{{\n\"threads\":{},\"repeats\":{},\"unit\":\"ns/op\",\"benchmarks\":[", jobs.workerCount(), repeats);
+		for (size_t i = 0; i < results.size(); i++) {
+			const Result& result = results[i];
+			const BenchStats& s = result.stats;
+			std::string samples;
+			for (size_t j = 0; j < result.samples.size(); j++) {
+				samples += std::format("{}{:.3f}", j ? "," : "", result.samples[j]);
+			}
+			file << std::format("{}\n{{\"name\":\"{}\",\"ops\":{},\"min\":{:.3f},\"median\":{:.3f},\"mean\":{:.3f},\"stddev\":{:.3f},"
+				"\"p95\":{:.3f},\"max\":{:.3f},\"samples\":[{}]}}", i ? "," : "", result.benchmark->name, result.benchmark->ops, s.min,
+				s.median, s.mean, s.stddev, s.p95, s.max, samples);
+		}
+		file << "\n]}\n";
+		std::cout << "results written to " << jsonPath << std::endl;
+	}
+
+	SDL_Quit();
+	return 0;
+}
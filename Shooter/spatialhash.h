@@ -0,0 +1,73 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Uniform grid over world space. Items are bucketed by every cell their bounds overlap,
+// so a query only has to look at the few cells around the bounds it is given.
+template<typename T>
+class SpatialHash {
+	float cellSize;
+	std::unordered_map<uint64_t, std::vector<T>> cells;
+
+	static uint64_t key(int x, int y) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+	}
+
+	int cellCoord(float v) const {
+		return static_cast<int>(std::floor(v / cellSize));
+	}
+
+public:
+	SpatialHash(float cellSize) : cellSize(cellSize)
+	{
+	}
+
+	// empties every cell but keeps their storage around for the next rebuild,
+	// cells nothing was inserted into since the last rebuild are dropped
+	void clear() {
+		for (auto it = cells.begin(); it != cells.end();) {
+			if (it->second.empty()) {
+				it = cells.erase(it);
+			}
+			else {
+				it->second.clear();
+				++it;
+			}
+		}
+	}
+
+	void insert(const SDL_FRect& bounds, T item) {
+		const int x0 = cellCoord(bounds.x), x1 = cellCoord(bounds.x + bounds.w);
+		const int y0 = cellCoord(bounds.y), y1 = cellCoord(bounds.y + bounds.h);
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				cells[key(x, y)].push_back(item);
+			}
+		}
+	}
+
+	// appends every item sharing a cell with bounds to out, each one once
+	void query(const SDL_FRect& bounds, std::vector<T>& out) const {
+		const size_t first = out.size();
+		const int x0 = cellCoord(bounds.x), x1 = cellCoord(bounds.x + bounds.w);
+		const int y0 = cellCoord(bounds.y), y1 = cellCoord(bounds.y + bounds.h);
+		for (int y = y0; y <= y1; y++) {
+			for (int x = x0; x <= x1; x++) {
+				auto it = cells.find(key(x, y));
+				if (it != cells.end()) {
+					out.insert(out.end(), it->second.begin(), it->second.end());
+				}
+			}
+		}
+
+		// items spanning several cells show up more than once
+		if (x0 != x1 || y0 != y1) {
+			std::sort(out.begin() + first, out.end());
+			out.erase(std::unique(out.begin() + first, out.end()), out.end());
+		}
+	}
+};
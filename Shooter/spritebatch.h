@@ -0,0 +1,88 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include <utility>
+
+// Collects textured quads and draws them with one SDL_RenderGeometry call per texture on flush().
+// Quads of the same texture keep their order, quads of different textures are drawn texture by texture,
+// so flush between layers that have to stay on top of each other.
+class SpriteBatch {
+	struct Batch {
+		SDL_Texture* texture;
+		std::vector<SDL_Vertex> vertices;
+		std::vector<int> indices;
+	};
+
+	std::vector<Batch> batches;
+	size_t lastBatch;
+	int drawCalls, quads;
+
+	Batch& batchFor(SDL_Texture* texture) {
+		// consecutive quads mostly share a texture
+		if (lastBatch < batches.size() && batches[lastBatch].texture == texture) {
+			return batches[lastBatch];
+		}
+		for (size_t i = 0; i < batches.size(); i++) {
+			if (batches[i].texture == texture) {
+				lastBatch = i;
+				return batches[i];
+			}
+		}
+		lastBatch = batches.size();
+		batches.push_back(Batch{ .texture = texture, .vertices = {}, .indices = {} });
+		return batches.back();
+	}
+
+public:
+	SpriteBatch() : lastBatch(0), drawCalls(0), quads(0) {}
+
+	// src in texels of texture, dst in render coordinates
+	void draw(SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst, SDL_FlipMode flip = SDL_FLIP_NONE) {
+		if (!texture) {
+			return;
+		}
+
+		float u0 = src.x / texture->w, u1 = (src.x + src.w) / texture->w;
+		float v0 = src.y / texture->h, v1 = (src.y + src.h) / texture->h;
+		if (flip & SDL_FLIP_HORIZONTAL) {
+			std::swap(u0, u1);
+		}
+		if (flip & SDL_FLIP_VERTICAL) {
+			std::swap(v0, v1);
+		}
+
+		Batch& batch = batchFor(texture);
+		const int base = static_cast<int>(batch.vertices.size());
+		const SDL_FColor white{ 1, 1, 1, 1 };
+		batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y }, white, { u0, v0 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y }, white, { u1, v0 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y + dst.h }, white, { u1, v1 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y + dst.h }, white, { u0, v1 } });
+		batch.indices.insert(batch.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+		quads++;
+	}
+
+	// the whole texture
+	void draw(SDL_Texture* texture, const SDL_FRect& dst) {
+		if (texture) {
+			draw(texture, SDL_FRect{ 0, 0, static_cast<float>(texture->w), static_cast<float>(texture->h) }, dst);
+		}
+	}
+
+	void flush(SDL_Renderer* renderer) {
+		for (Batch& batch : batches) {
+			if (!batch.indices.empty()) {
+				SDL_RenderGeometry(renderer, batch.texture, batch.vertices.data(), static_cast<int>(batch.vertices.size()),
+					batch.indices.data(), static_cast<int>(batch.indices.size()));
+				drawCalls++;
+				batch.vertices.clear();
+				batch.indices.clear();
+			}
+		}
+	}
+
+	// geometry calls made and quads drawn since the last reset
+	int getDrawCalls() const { return drawCalls; }
+	int getQuads() const { return quads; }
+	void resetStats() { drawCalls = quads = 0; }
+};
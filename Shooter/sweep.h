@@ -0,0 +1,60 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <limits>
+
+struct SweepHit {
+	float time;	// fraction of the move at which the boxes first touch, 0..1
+};
+
+// Moves box by delta and finds the first moment it overlaps target. Boxes that already
+// overlap hit at time 0; boxes that only slide along each other's edges never hit.
+inline bool sweepAABB(const SDL_FRect& box, glm::vec2 delta, const SDL_FRect& target, SweepHit& hit) {
+
+	const float inf = std::numeric_limits<float>::infinity();
+	float entryX = -inf, exitX = inf, entryY = -inf, exitY = inf;
+
+	if (delta.x == 0) {
+		if (box.x + box.w <= target.x || target.x + target.w <= box.x) {
+			return false;
+		}
+	}
+	else {
+		const float t1 = (target.x - (box.x + box.w)) / delta.x;
+		const float t2 = (target.x + target.w - box.x) / delta.x;
+		entryX = std::min(t1, t2);
+		exitX = std::max(t1, t2);
+	}
+
+	if (delta.y == 0) {
+		if (box.y + box.h <= target.y || target.y + target.h <= box.y) {
+			return false;
+		}
+	}
+	else {
+		const float t1 = (target.y - (box.y + box.h)) / delta.y;
+		const float t2 = (target.y + target.h - box.y) / delta.y;
+		entryY = std::min(t1, t2);
+		exitY = std::max(t1, t2);
+	}
+
+	const float entry = std::max(entryX, entryY);
+	const float exit = std::min(exitX, exitY);
+	if (entry >= exit || entry > 1 || exit <= 0) {
+		return false;
+	}
+
+	hit.time = std::max(entry, 0.0f);
+	return true;
+}
+
+// the bounds covering box over the whole move
+inline SDL_FRect sweptBounds(const SDL_FRect& box, glm::vec2 delta) {
+	return SDL_FRect{
+		.x = std::min(box.x, box.x + delta.x),
+		.y = std::min(box.y, box.y + delta.y),
+		.w = box.w + std::abs(delta.x),
+		.h = box.h + std::abs(delta.y)
+	};
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include "tilegrid.h"
+#include "spritebatch.h"
+#include "atlas.h"
+
+// A tile layer baked into render-target textures a fixed number of columns wide, so drawing it is a
+// texture per chunk in view instead of a quad per tile. There are only enough textures for the grid's
+// window of columns: chunk i is baked into texture i % textures, and again whenever the columns it
+// covers have changed since, which is checked as it comes into view.
+class TileChunks {
+	struct Chunk {
+		SDL_Texture* texture;
+		int index;			// of the chunk last baked into the texture, -1 for none
+		uint32_t revision;	// of the grid when it was baked
+	};
+
+	const TileGrid* grid;
+	std::vector<Chunk> chunks;
+	int chunkCols, levelChunks;
+
+	bool isStale(int index) const {
+		const Chunk& chunk = chunks[index % chunks.size()];
+		const int c0 = index * chunkCols;
+		return chunk.index != index || chunk.revision != grid->getRevision(c0, std::min(c0 + chunkCols, grid->getCols()));
+	}
+
+	void bake(SDL_Renderer* renderer, SpriteBatch& batch, std::span<const SpriteRef> tileSprites, int index) {
+		Chunk& chunk = chunks[index % chunks.size()];
+		const int c0 = index * chunkCols;
+		const int c1 = std::min(c0 + chunkCols, grid->getCols());
+
+		SDL_Texture* target = SDL_GetRenderTarget(renderer);
+		SDL_SetRenderTarget(renderer, chunk.texture);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+
+		const float tileSize = grid->getTileSize();
+		for (int r = 0; r < grid->getRows(); r++) {
+			for (int c = c0; c < c1; c++) {
+				const uint16_t id = grid->get(r, c);
+				if (id) {
+					const SpriteRef& tile = tileSprites[id];
+					batch.draw(tile.atlas, tile.rect, SDL_FRect{ .x = (c - c0) * tileSize, .y = r * tileSize, .w = tileSize, .h = tileSize });
+				}
+			}
+		}
+		batch.flush(renderer);
+
+		SDL_SetRenderTarget(renderer, target);
+		chunk.index = index;
+		chunk.revision = grid->getRevision(c0, c1);
+	}
+
+	// the chunks within margin of view, first > last when there are none
+	void visibleRange(const SDL_FRect& view, float margin, int& first, int& last) const {
+		const float chunkWidth = chunkCols * grid->getTileSize();
+		const glm::vec2 origin = grid->getOrigin();
+		first = std::max(static_cast<int>(std::floor((view.x - margin - origin.x) / chunkWidth)), 0);
+		last = std::min(static_cast<int>(std::floor((view.x + view.w + margin - origin.x) / chunkWidth)), levelChunks - 1);
+	}
+
+public:
+	TileChunks() : grid(nullptr), chunkCols(0), levelChunks(0) {}
+
+	// creates the chunk textures for grid, they are baked the first time they are drawn. The grid's window
+	// has to be a multiple of chunkCols wide unless it covers the whole layer
+	bool create(SDL_Renderer* renderer, const TileGrid& grid, int chunkCols) {
+		release();
+		this->grid = &grid;
+		this->chunkCols = chunkCols;
+		levelChunks = (grid.getCols() + chunkCols - 1) / chunkCols;
+
+		const int tileSize = static_cast<int>(grid.getTileSize());
+		const int textures = (grid.getWindowCols() + chunkCols - 1) / chunkCols;
+		for (int i = 0; i < textures; i++) {
+			SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+				chunkCols * tileSize, grid.getRows() * tileSize);
+			if (!texture) {
+				return false;
+			}
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+			SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+			chunks.push_back(Chunk{ .texture = texture, .index = -1, .revision = 0 });
+		}
+		return true;
+	}
+
+	void release() {
+		for (Chunk& chunk : chunks) {
+			SDL_DestroyTexture(chunk.texture);
+		}
+		chunks.clear();
+	}
+
+	// chunks the whole layer is split into
+	size_t chunkCount() const { return static_cast<size_t>(levelChunks); }
+
+	// bakes up to budget stale chunks that are in memory within distance of view but not in it yet,
+	// nearest first, so they are ready by the time they scroll in. Returns how many were baked
+	int prebake(SDL_Renderer* renderer, SpriteBatch& batch, std::span<const SpriteRef> tileSprites, const SDL_FRect& view,
+		float distance, int budget) {
+		if (chunks.empty()) {
+			return 0;
+		}
+
+		int first, last, nearFirst, nearLast;
+		visibleRange(view, 0, first, last);
+		visibleRange(view, distance, nearFirst, nearLast);
+		int baked = 0;
+		for (int d = 1; baked < budget && (last + d <= nearLast || first - d >= nearFirst); d++) {
+			for (int index : { last + d, first - d }) {
+				if (baked < budget && index >= nearFirst && index <= nearLast && grid->isResident(index * chunkCols) && isStale(index)) {
+					bake(renderer, batch, tileSprites, index);
+					baked++;
+				}
+			}
+		}
+		return baked;
+	}
+
+	// draws the chunks within margin of view, offset so view.x is at the left edge of the screen.
+	// The chunks are found from the columns view spans, returns how many were drawn
+	int draw(SDL_Renderer* renderer, SpriteBatch& batch, std::span<const SpriteRef> tileSprites, const SDL_FRect& view,
+		float margin) {
+		if (chunks.empty()) {
+			return 0;
+		}
+
+		int first, last;
+		visibleRange(view, margin, first, last);
+		if (first > last) {
+			return 0;
+		}
+
+		// bake first, baking switches the render target
+		for (int i = first; i <= last; i++) {
+			if (isStale(i)) {
+				bake(renderer, batch, tileSprites, i);
+			}
+		}
+
+		const float chunkWidth = chunkCols * grid->getTileSize();
+		const glm::vec2 origin = grid->getOrigin();
+		for (int i = first; i <= last; i++) {
+			SDL_Texture* texture = chunks[i % chunks.size()].texture;
+			const SDL_FRect dst{
+				.x = origin.x + i * chunkWidth - view.x,
+				.y = origin.y,
+				.w = static_cast<float>(texture->w),
+				.h = static_cast<float>(texture->h)
+			};
+			batch.draw(texture, dst);
+		}
+		batch.flush(renderer);
+		return last - first + 1;
+	}
+};
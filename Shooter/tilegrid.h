@@ -0,0 +1,141 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "sweep.h"
+
+// A layer of square tiles stored as one tile id per cell, 0 meaning empty.
+// Only a window of the layer's columns has to be in memory: column c lives in slot c % windowCols,
+// and columns that aren't in their slot read as empty. A grid whose window is as wide as the layer
+// holds all of it.
+// Every change bumps a revision that is also kept per slot, so caches of the layer can tell
+// which part of it went stale.
+class TileGrid {
+	std::vector<uint16_t> tiles;	// windowCols slots of rows tiles each
+	std::vector<int> slotColumns;	// the column in each slot, -1 for none
+	std::vector<uint32_t> slotRevisions;
+	uint32_t revision;
+	int rows, cols, windowCols;
+	float tileSize;
+	glm::vec2 origin;
+
+	size_t slotOf(int c) const { return static_cast<size_t>(c % windowCols); }
+
+public:
+	TileGrid() : revision(0), rows(0), cols(0), windowCols(1), tileSize(0), origin(0) {}
+
+	// the whole layer in memory, empty
+	void resize(int rows, int cols, float tileSize, glm::vec2 origin) {
+		resizeWindow(rows, cols, tileSize, origin, cols);
+		for (int c = 0; c < cols; c++) {
+			slotColumns[c] = c;
+		}
+	}
+
+	// room for windowCols columns at a time, none of them in memory yet
+	void resizeWindow(int rows, int cols, float tileSize, glm::vec2 origin, int windowCols) {
+		this->rows = rows;
+		this->cols = cols;
+		this->windowCols = std::max(std::min(windowCols, cols), 1);
+		this->tileSize = tileSize;
+		this->origin = origin;
+		tiles.assign(static_cast<size_t>(rows) * this->windowCols, 0);
+		slotColumns.assign(this->windowCols, -1);
+		slotRevisions.assign(this->windowCols, ++revision);
+	}
+
+	// puts count columns from c0 on in memory, replacing what was in their slots. ids holds them
+	// one column after the other, rows ids each
+	void setColumns(int c0, int count, const uint16_t* ids) {
+		for (int c = c0; c < c0 + count; c++) {
+			const size_t slot = slotOf(c);
+			std::copy_n(ids + static_cast<size_t>(c - c0) * rows, rows, tiles.begin() + slot * rows);
+			slotColumns[slot] = c;
+			slotRevisions[slot] = ++revision;
+		}
+	}
+
+	// drops the columns [c0, c0 + count) that are in memory
+	void evictColumns(int c0, int count) {
+		for (int c = c0; c < c0 + count; c++) {
+			const size_t slot = slotOf(c);
+			if (slotColumns[slot] == c) {
+				slotColumns[slot] = -1;
+				slotRevisions[slot] = ++revision;
+			}
+		}
+	}
+
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	int getWindowCols() const { return windowCols; }
+	float getTileSize() const { return tileSize; }
+	glm::vec2 getOrigin() const { return origin; }
+	size_t memoryUsage() const { return tiles.capacity() * sizeof(uint16_t); }
+	bool isResident(int c) const { return slotColumns[slotOf(c)] == c; }
+
+	uint16_t get(int r, int c) const {
+		const size_t slot = slotOf(c);
+		return slotColumns[slot] == c ? tiles[slot * rows + r] : 0;
+	}
+
+	// only columns in memory can be changed
+	void set(int r, int c, uint16_t id) {
+		const size_t slot = slotOf(c);
+		if (slotColumns[slot] == c) {
+			tiles[slot * rows + r] = id;
+			slotRevisions[slot] = ++revision;
+		}
+	}
+
+	// the revision of the last change to the slots of the columns [c0, c1)
+	uint32_t getRevision(int c0, int c1) const {
+		uint32_t latest = 0;
+		for (int c = c0; c < c1; c++) {
+			latest = std::max(latest, slotRevisions[slotOf(c)]);
+		}
+		return latest;
+	}
+
+	SDL_FRect cellRect(int r, int c) const {
+		return SDL_FRect{
+			.x = origin.x + c * tileSize,
+			.y = origin.y + r * tileSize,
+			.w = tileSize,
+			.h = tileSize
+		};
+	}
+
+	// calls fn(r, c, id) for every non-empty cell touching bounds, edges included, in row-major order
+	template<typename Fn>
+	void forEachOverlapping(const SDL_FRect& bounds, Fn&& fn) const {
+		const int c0 = std::max(static_cast<int>(std::ceil((bounds.x - origin.x) / tileSize)) - 1, 0);
+		const int c1 = std::min(static_cast<int>(std::floor((bounds.x + bounds.w - origin.x) / tileSize)), cols - 1);
+		const int r0 = std::max(static_cast<int>(std::ceil((bounds.y - origin.y) / tileSize)) - 1, 0);
+		const int r1 = std::min(static_cast<int>(std::floor((bounds.y + bounds.h - origin.y) / tileSize)), rows - 1);
+		for (int r = r0; r <= r1; r++) {
+			for (int c = c0; c <= c1; c++) {
+				const uint16_t id = get(r, c);
+				if (id) {
+					fn(r, c, id);
+				}
+			}
+		}
+	}
+
+	// the earliest hit of box moving by delta against any non-empty cell
+	bool sweep(const SDL_FRect& box, glm::vec2 delta, SweepHit& hit) const {
+		bool found = false;
+		forEachOverlapping(sweptBounds(box, delta), [&](int r, int c, uint16_t) {
+			SweepHit cellHit;
+			if (sweepAABB(box, delta, cellRect(r, c), cellHit) && (!found || cellHit.time < hit.time)) {
+				hit = cellHit;
+				found = true;
+			}
+		});
+		return found;
+	}
+};
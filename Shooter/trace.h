@@ -0,0 +1,191 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes timed events to Chrome trace JSON files, which chrome://tracing and Perfetto open, on a thread
+// of its own. Events are handed over in blocks and at most MAX_BLOCKS of them wait to be written; when
+// the writer falls further behind than that, whole blocks are dropped and counted rather than letting
+// the queue grow. A capture's drop count goes in its file and is printed once the file is written. Only
+// the thread handing events over touches the block being filled.
+class TraceWriter {
+public:
+	struct Event {
+		const char* name;	// has to outlive the writer, phase names are string literals
+		uint32_t thread;
+		uint64_t start, end;	// ns
+	};
+
+private:
+	static const size_t BLOCK_EVENTS = 4096;
+	static const size_t MAX_BLOCKS = 16;
+
+	struct Item {
+		enum class Kind {
+			open, events, close
+		} kind;
+		std::string path;					// open
+		std::vector<Event> events;			// events
+		std::vector<std::string> threads;	// close, the name of every thread by index
+		uint64_t dropped;					// close, events of this capture that were dropped
+	};
+
+	std::vector<Event> block;
+	bool capturing;
+	// events of the current capture lost to the writer falling behind
+	uint64_t dropped;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<Item> queue;
+	std::vector<std::vector<Event>> spare;
+	size_t queuedBlocks;
+	bool stopping;
+
+	void push(Item&& item) {
+		{
+			std::lock_guard lock(mutex);
+			queue.push_back(std::move(item));
+		}
+		wake.notify_one();
+	}
+
+	void flushBlock() {
+		if (block.empty()) {
+			return;
+		}
+		std::unique_lock lock(mutex);
+		if (queuedBlocks == MAX_BLOCKS) {
+			dropped += block.size();
+			block.clear();
+			return;
+		}
+		queuedBlocks++;
+		queue.push_back(Item{ .kind = Item::Kind::events, .path = {}, .events = std::move(block), .threads = {}, .dropped = 0 });
+		if (!spare.empty()) {
+			block = std::move(spare.back());
+			spare.pop_back();
+		}
+		lock.unlock();
+		wake.notify_one();
+		block.reserve(BLOCK_EVENTS);
+	}
+
+	void run() {
+		std::ofstream file;
+		std::string path;
+		bool first = true;
+		std::string text;
+		std::unique_lock lock(mutex);
+		while (true) {
+			wake.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty()) {
+				return;
+			}
+			Item item = std::move(queue.front());
+			queue.erase(queue.begin());
+			lock.unlock();
+
+			switch (item.kind) {
+				case Item::Kind::open: {
+					path = std::move(item.path);
+					file.open(path, std::ios::trunc);
+					file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+					first = true;
+					break;
+				}
+
+				case Item::Kind::events: {
+					text.clear();
+					for (const Event& event : item.events) {
+						text += std::format("{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+							first ? "" : ",", event.name, event.thread, event.start / 1e3, (event.end - event.start) / 1e3);
+						first = false;
+					}
+					file << text;
+					break;
+				}
+
+				case Item::Kind::close: {
+					for (size_t i = 0; i < item.threads.size(); i++) {
+						file << std::format("{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+							first ? "" : ",", i, item.threads[i]);
+						first = false;
+					}
+					// a viewer shows the label next to the process, so a capture with holes in it says so
+					if (item.dropped > 0) {
+						file << std::format("{}\n{{\"name\":\"process_labels\",\"ph\":\"M\",\"pid\":1,\"args\":{{\"labels\":\"{} events dropped\"}}}}",
+							first ? "" : ",", item.dropped);
+						first = false;
+					}
+					file << "\n]}\n";
+					file.close();
+					std::cout << std::format("trace written to {}, {} events dropped", path, item.dropped) << std::endl;
+					break;
+				}
+			}
+
+			lock.lock();
+			if (item.kind == Item::Kind::events) {
+				item.events.clear();
+				spare.push_back(std::move(item.events));
+				queuedBlocks--;
+			}
+		}
+	}
+
+public:
+	TraceWriter() : capturing(false), dropped(0), queuedBlocks(0), stopping(false) {}
+
+	// finishes the file being written, if any
+	~TraceWriter() {
+		if (capturing) {
+			close({});
+		}
+		if (thread.joinable()) {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+			wake.notify_one();
+			thread.join();
+		}
+	}
+
+	TraceWriter(const TraceWriter&) = delete;
+	TraceWriter& operator=(const TraceWriter&) = delete;
+
+	bool isCapturing() const { return capturing; }
+
+	// starts a new file, the writer thread is started with the first one
+	void open(const std::string& path) {
+		if (!thread.joinable()) {
+			thread = std::thread(&TraceWriter::run, this);
+		}
+		capturing = true;
+		dropped = 0;
+		block.reserve(BLOCK_EVENTS);
+		push(Item{ .kind = Item::Kind::open, .path = path, .events = {}, .threads = {}, .dropped = 0 });
+	}
+
+	void add(const Event& event) {
+		block.push_back(event);
+		if (block.size() == BLOCK_EVENTS) {
+			flushBlock();
+		}
+	}
+
+	// ends the file, threads names the threads by the index events were added with
+	void close(std::vector<std::string> threads) {
+		flushBlock();
+		capturing = false;
+		push(Item{ .kind = Item::Kind::close, .path = {}, .events = {}, .threads = std::move(threads), .dropped = dropped });
+	}
+};
@@ -0,0 +1,385 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <array>
+#include <cassert>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "levelfile.h"
+#include "tilegrid.h"
+#include "profiler.h"
+
+// Streams a level file into windowed tile grids in chunks a fixed number of columns wide. A background
+// thread reads and checks the chunks near the view; the caller's thread only copies finished chunks into
+// the grids, so the grids are never touched while the simulation runs. Chunks more than a little past
+// the preloaded ones are evicted, so the memory used depends on the view, not on the length of the level.
+//
+// update() blocks until every chunk the view needs is in, which only happens when the stream falls
+// behind. What the simulation touches is therefore the same however quickly chunks arrive.
+class WorldStream {
+public:
+	static const size_t LAYERS = static_cast<size_t>(levelfile::LayerKind::count);
+
+	struct Stats {
+		int residentChunks = 0, capacity = 0, pendingChunks = 0;
+		uint64_t loads = 0, evictions = 0;
+		// blocking waits for chunks the view needed and the time spent in them
+		uint64_t stalls = 0, stallNs = 0;
+		// from requesting a chunk to its being in the grids
+		uint64_t lastLatencyNs = 0, maxLatencyNs = 0, totalLatencyNs = 0;
+		// spent by the stream thread reading and checking chunks
+		uint64_t readNs = 0;
+
+		double averageLatencyMs() const { return loads ? totalLatencyNs / 1e6 / loads : 0; }
+	};
+
+private:
+	// a chunk on its way from the file to the grids, the buffers are reused from chunk to chunk
+	struct ChunkData {
+		int index = -1;
+		std::array<std::vector<uint16_t>, LAYERS> layers;	// chunkCols columns of rows ids each, by LayerKind
+		std::vector<levelfile::Spawn> spawns;
+		uint64_t requestedNs = 0, readNs = 0;
+		std::string error;
+	};
+
+	enum class SlotState {
+		empty, pending, resident
+	};
+
+	// chunk i can only be in slot i % slots.size(), as the grids keep column c in slot c % window
+	struct Slot {
+		int index = -1;
+		SlotState state = SlotState::empty;
+	};
+
+	std::string path;
+	uint16_t tileIdCount;
+	levelfile::Index index;
+	int chunkCols, chunkCount, preload;
+	std::vector<Slot> slots;
+	std::array<TileGrid*, LAYERS> grids;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable requested, loaded;
+	std::vector<ChunkData> requests, done, spare;
+	std::vector<ChunkData> arrived;
+	bool stopping;
+
+	Stats stats;
+	std::string error;
+
+	// on the stream thread
+	void read(std::ifstream& file, std::vector<uint16_t>& row, ChunkData& chunk) const {
+		const int rows = static_cast<int>(index.header.rows);
+		const int c0 = chunk.index * chunkCols;
+		const int count = std::min(chunkCols, static_cast<int>(index.header.cols) - c0);
+		chunk.error.clear();
+		chunk.spawns.clear();
+		for (std::vector<uint16_t>& layer : chunk.layers) {
+			layer.assign(static_cast<size_t>(rows) * count, 0);
+		}
+
+		// rows are contiguous in the file, the grids want columns
+		row.resize(count);
+		for (size_t i = 0; i < index.kinds.size(); i++) {
+			std::vector<uint16_t>& layer = chunk.layers[static_cast<size_t>(index.kinds[i])];
+			for (int r = 0; r < rows; r++) {
+				file.seekg(static_cast<std::streamoff>(index.cellOffset(i, r, c0)));
+				file.read(reinterpret_cast<char*>(row.data()), count * sizeof(uint16_t));
+				if (!file) {
+					file.clear();
+					chunk.error = "read failed";
+					return;
+				}
+				if (!levelfile::checkTiles(row.data(), row.size(), tileIdCount, chunk.error)) {
+					return;
+				}
+				for (int c = 0; c < count; c++) {
+					layer[static_cast<size_t>(c) * rows + r] = row[c];
+				}
+			}
+		}
+
+		for (const levelfile::Spawn& spawn : index.spawns) {
+			if (static_cast<int>(spawn.col) >= c0 && static_cast<int>(spawn.col) < c0 + count) {
+				chunk.spawns.push_back(spawn);
+			}
+		}
+	}
+
+	void run() {
+		PROFILE_THREAD("stream");
+		std::ifstream file(path, std::ios::binary);
+		std::vector<uint16_t> row;
+		std::unique_lock lock(mutex);
+		while (true) {
+			requested.wait(lock, [this] { return stopping || !requests.empty(); });
+			if (stopping) {
+				return;
+			}
+			// nearest to the view first, see update()
+			ChunkData chunk = std::move(requests.front());
+			requests.erase(requests.begin());
+			lock.unlock();
+
+			const uint64_t start = SDL_GetTicksNS();
+			{
+				PROFILE_SCOPE(chunkRead);
+				read(file, row, chunk);
+			}
+			chunk.readNs = SDL_GetTicksNS() - start;
+
+			lock.lock();
+			done.push_back(std::move(chunk));
+			loaded.notify_all();
+		}
+	}
+
+	// copies the chunks that came in since the last call into the grids
+	template<typename SpawnFn>
+	bool install(SpawnFn& onSpawn) {
+		{
+			std::lock_guard lock(mutex);
+			std::swap(arrived, done);
+		}
+
+		for (ChunkData& chunk : arrived) {
+			Slot& slot = slots[chunk.index % slots.size()];
+			// dropped while it was being read
+			if (slot.index != chunk.index || slot.state != SlotState::pending) {
+				continue;
+			}
+			if (!chunk.error.empty()) {
+				error = "chunk " + std::to_string(chunk.index) + ": " + chunk.error;
+				continue;
+			}
+
+			const int c0 = chunk.index * chunkCols;
+			const int count = std::min(chunkCols, static_cast<int>(index.header.cols) - c0);
+			for (size_t layer = 0; layer < LAYERS; layer++) {
+				grids[layer]->setColumns(c0, count, chunk.layers[layer].data());
+			}
+			for (const levelfile::Spawn& spawn : chunk.spawns) {
+				onSpawn(spawn);
+			}
+			slot.state = SlotState::resident;
+
+			const uint64_t latency = SDL_GetTicksNS() - chunk.requestedNs;
+			stats.loads++;
+			stats.lastLatencyNs = latency;
+			stats.maxLatencyNs = std::max(stats.maxLatencyNs, latency);
+			stats.totalLatencyNs += latency;
+			stats.readNs += chunk.readNs;
+		}
+
+		std::lock_guard lock(mutex);
+		for (ChunkData& chunk : arrived) {
+			spare.push_back(std::move(chunk));
+		}
+		arrived.clear();
+		return error.empty();
+	}
+
+	void evict(Slot& slot) {
+		if (slot.state == SlotState::resident) {
+			for (TileGrid* grid : grids) {
+				grid->evictColumns(slot.index * chunkCols, chunkCols);
+			}
+			stats.evictions++;
+		}
+		slot = Slot();
+	}
+
+	// under the lock, false if the chunk is already in or on its way
+	bool request(int chunk, uint64_t now) {
+		Slot& slot = slots[chunk % slots.size()];
+		if (slot.index == chunk) {
+			return false;
+		}
+		evict(slot);
+		slot = Slot{ .index = chunk, .state = SlotState::pending };
+
+		if (spare.empty()) {
+			spare.emplace_back();
+		}
+		ChunkData data = std::move(spare.back());
+		spare.pop_back();
+		data.index = chunk;
+		data.requestedNs = now;
+		requests.push_back(std::move(data));
+		return true;
+	}
+
+public:
+	WorldStream() : tileIdCount(0), chunkCols(1), chunkCount(0), preload(0), grids{}, stopping(false) {}
+	~WorldStream() { close(); }
+
+	WorldStream(const WorldStream&) = delete;
+	WorldStream& operator=(const WorldStream&) = delete;
+
+	// reads the level's header and spawn points, the tiles are read as they are needed. viewCols is the
+	// most columns a view passed to update() spans, preload how many chunks to keep loaded either side of it
+	bool open(const std::string& path, uint16_t tileIdCount, int chunkCols, int viewCols, int preload, std::string& error) {
+		close();
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			error = "can't open " + path;
+			return false;
+		}
+		const size_t fileSize = static_cast<size_t>(file.tellg());
+		file.seekg(0);
+
+		// a header that doesn't fit the file is left for readIndex to reject
+		levelfile::Header header{};
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		const size_t size = levelfile::indexSize(header);
+		std::vector<uint8_t> bytes(size > sizeof(header) && size <= fileSize ? size : sizeof(header));
+		std::memcpy(bytes.data(), &header, sizeof(header));
+		file.read(reinterpret_cast<char*>(bytes.data()) + sizeof(header), bytes.size() - sizeof(header));
+		if (!levelfile::readIndex(bytes.data(), bytes.size(), fileSize, index, error)) {
+			return false;
+		}
+
+		this->path = path;
+		this->tileIdCount = tileIdCount;
+		this->chunkCols = chunkCols;
+		this->preload = preload;
+		chunkCount = (static_cast<int>(index.header.cols) + chunkCols - 1) / chunkCols;
+		// the view can straddle one more chunk than it spans, one more either side keeps a chunk at the
+		// edge of the preloaded ones from being evicted and read again as the view wobbles across a border
+		const int viewChunks = (viewCols + chunkCols - 1) / chunkCols + 1;
+		slots.assign(std::min(viewChunks + 2 * (preload + 1), chunkCount), Slot());
+		stats = Stats();
+		stats.capacity = static_cast<int>(slots.size());
+		this->error.clear();
+		stopping = false;
+		thread = std::thread(&WorldStream::run, this);
+		return true;
+	}
+
+	void close() {
+		if (thread.joinable()) {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+			requested.notify_all();
+			thread.join();
+		}
+		for (std::vector<ChunkData>* list : { &requests, &done }) {
+			for (ChunkData& chunk : *list) {
+				spare.push_back(std::move(chunk));
+			}
+			list->clear();
+		}
+		slots.clear();
+	}
+
+	const levelfile::Header& header() const { return index.header; }
+	const std::vector<levelfile::Spawn>& spawns() const { return index.spawns; }
+	// how many columns the grids have to hold, a multiple of chunkCols unless it is the whole level
+	int windowCols() const { return std::min(static_cast<int>(slots.size()) * chunkCols, static_cast<int>(index.header.cols)); }
+	const Stats& getStats() const { return stats; }
+	const std::string& getError() const { return error; }
+
+	// the grids chunks are copied into, by LayerKind, made with windowCols() columns
+	void attach(const std::array<TileGrid*, LAYERS>& grids) { this->grids = grids; }
+
+	// streams towards the view spanning the columns [c0, c1]: brings in what came off the disk, evicts
+	// the chunks too far from it and asks for the ones that are missing, nearest first. Waits for the
+	// chunks under the view itself. onSpawn(spawn) is called for the spawn points of a chunk every time
+	// it comes in. False once a chunk failed to load, getError() says why
+	template<typename SpawnFn>
+	bool update(int c0, int c1, SpawnFn&& onSpawn) {
+		if (!error.empty() || slots.empty()) {
+			return error.empty();
+		}
+		const int first = std::clamp(c0 / chunkCols, 0, chunkCount - 1);
+		const int last = std::clamp(c1 / chunkCols, first, chunkCount - 1);
+		const int keepFirst = std::max(first - preload - 1, 0);
+		const int keepLast = std::min(last + preload + 1, chunkCount - 1);
+		// a view wider than viewCols would have chunks fight over slots
+		assert(keepLast - keepFirst < static_cast<int>(slots.size()));
+
+		if (!install(onSpawn)) {
+			return false;
+		}
+
+		bool requestedAny = false;
+		{
+			std::lock_guard lock(mutex);
+			// requests nobody wants anymore are dropped before they are read
+			for (size_t i = 0; i < requests.size(); ) {
+				if (requests[i].index < keepFirst || requests[i].index > keepLast) {
+					slots[requests[i].index % slots.size()] = Slot();
+					spare.push_back(std::move(requests[i]));
+					requests.erase(requests.begin() + i);
+				}
+				else {
+					i++;
+				}
+			}
+			for (Slot& slot : slots) {
+				if (slot.index != -1 && (slot.index < keepFirst || slot.index > keepLast)) {
+					evict(slot);
+				}
+			}
+
+			// the view, then outwards from it
+			const uint64_t now = SDL_GetTicksNS();
+			for (int i = first; i <= last; i++) {
+				requestedAny |= request(i, now);
+			}
+			for (int d = 1; d <= preload; d++) {
+				if (last + d < chunkCount) {
+					requestedAny |= request(last + d, now);
+				}
+				if (first - d >= 0) {
+					requestedAny |= request(first - d, now);
+				}
+			}
+		}
+		if (requestedAny) {
+			requested.notify_one();
+		}
+
+		const auto missing = [&] {
+			for (int i = first; i <= last; i++) {
+				if (slots[i % slots.size()].state != SlotState::resident) {
+					return true;
+				}
+			}
+			return false;
+		};
+		if (missing()) {
+			const uint64_t start = SDL_GetTicksNS();
+			while (missing()) {
+				{
+					std::unique_lock lock(mutex);
+					loaded.wait(lock, [this] { return !done.empty(); });
+				}
+				if (!install(onSpawn)) {
+					return false;
+				}
+			}
+			stats.stalls++;
+			stats.stallNs += SDL_GetTicksNS() - start;
+		}
+
+		stats.residentChunks = 0;
+		stats.pendingChunks = 0;
+		for (const Slot& slot : slots) {
+			stats.residentChunks += slot.state == SlotState::resident;
+			stats.pendingChunks += slot.state == SlotState::pending;
+		}
+		return true;
+	}
+};